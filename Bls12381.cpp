@@ -0,0 +1,834 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2014-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+
+#include "Bls12381.h"
+
+using namespace std;
+using namespace dev;
+using namespace dev::crypto;
+using namespace dev::crypto::bls12_381;
+
+namespace
+{
+
+/// |z| for the BLS parameter z = -0xd201000000010000.
+BigInt<1> constexpr c_z{{0xd201000000010000}};
+
+/// A primitive cube root of unity in Fq for which the endomorphism
+/// (x, y) -> (beta x, y) acts on G1 as multiplication by -z^2.
+BigInt<6> constexpr c_beta{{
+	0x2e01fffffffefffe, 0xde17d813620a0002, 0xddb3a93be6f89688,
+	0xba69c6076a0f77ea, 0x5f19672fdf76ce51, 0x0000000000000000
+}};
+
+/// A' and B' of the curve E' 11-isogenous to E (RFC 9380 section 8.8.1).
+BigInt<6> constexpr c_g1SswuA{{
+	0x5cf428082d584c1d, 0x98936f8da0e0f97f, 0xd8e8981aefd881ac,
+	0xb0ea985383ee66a8, 0x3d693a02c96d4982, 0x00144698a3b8e943
+}};
+BigInt<6> constexpr c_g1SswuB{{
+	0xd1cc48e98e172be0, 0x5a23215a316ceaa5, 0xa0b9c14fcef35ef5,
+	0x2016c1f0f24f4070, 0x018b12e8753eee3b, 0x12e2908d11688030
+}};
+
+/// The isogeny maps of RFC 9380 appendix E, lowest degree first; the leading
+/// coefficient one of the denominators is omitted.
+BigInt<6> constexpr c_g1IsoXNum[] = {
+	{{
+		0xaeac1662734649b7, 0x5610c2d5f2e62d6e, 0xf2627b56cdb4e2c8,
+		0x6b303e88a2d7005f, 0xb809101dd9981585, 0x11a05f2b1e833340
+	}},
+	{{
+		0xe834eef1b3cb83bb, 0x4838f2a6f318c356, 0xf565e33c70d1e86b,
+		0x7c17e75b2f6a8417, 0x0588bab22147a81c, 0x17294ed3e943ab2f
+	}},
+	{{
+		0xe0179f9dac9edcb0, 0x958c3e3d2a09729f, 0x6878e501ec68e25c,
+		0xce032473295983e5, 0x1d1048c5d10a9a1b, 0x0d54005db97678ec
+	}},
+	{{
+		0xc5b388641d9b6861, 0x5336e25ce3107193, 0xf1b33289f1b33083,
+		0xd7f5e4656a8dbf25, 0x4e0609d307e55412, 0x1778e7166fcc6db7
+	}},
+	{{
+		0x51154ce9ac8895d9, 0x985a286f301e77c4, 0x086eeb65982fac18,
+		0x99db995a1257fb3f, 0x6642b4b3e4118e54, 0x0e99726a3199f443
+	}},
+	{{
+		0xcd13c1c66f652983, 0xa0870d2dcae73d19, 0x9ed3ab9097e68f90,
+		0xdb3cb17dd952799b, 0x01d1201bf7a74ab5, 0x1630c3250d7313ff
+	}},
+	{{
+		0xddd7f225a139ed84, 0x8da25128c1052eca, 0x9008e218f9c86b2a,
+		0xb11586264f0f8ce1, 0x6a3726c38ae652bf, 0x0d6ed6553fe44d29
+	}},
+	{{
+		0x9ccb5618e3f0c88e, 0x39b7c8f8c8f475af, 0xa682c62ef0f27533,
+		0x356de5ab275b4db1, 0xe8743884d1117e53, 0x17b81e7701abdbe2
+	}},
+	{{
+		0x6d71986a8497e317, 0x4fa295f296b74e95, 0xa2c596c928c5d1de,
+		0xc43b756ce79f5574, 0x7b90b33563be990d, 0x080d3cf1f9a78fc4
+	}},
+	{{
+		0x7f241067be390c9e, 0xa3190b2edc032779, 0x676314baf4bb1b7f,
+		0xdd2ecb803a0c5c99, 0x2e0c37515d138f22, 0x169b1f8e1bcfa7c4
+	}},
+	{{
+		0xca67df3f1605fb7b, 0xf69b771f8c285dec, 0xd50af36003b14866,
+		0xfa7dccdde6787f96, 0x72d8ec09d2565b0d, 0x10321da079ce07e2
+	}},
+	{{
+		0xa9c8ba2e8ba2d229, 0xc24b1b80b64d391f, 0x23c0bf1bc24c6b68,
+		0x31d79d7e22c837bc, 0xbd1e962381edee3d, 0x06e08c248e260e70
+	}}
+};
+
+BigInt<6> constexpr c_g1IsoXDen[] = {
+	{{
+		0x993cf9fa40d21b1c, 0xb558d681be343df8, 0x9c9588617fc8ac62,
+		0x01d5ef4ba35b48ba, 0x18b2e62f4bd3fa6f, 0x08ca8d548cff19ae
+	}},
+	{{
+		0xe5c8276ec82b3bff, 0x13daa8846cb026e9, 0x0126c2588c48bf57,
+		0x7041e8ca0cf0800c, 0x48b4711298e53636, 0x12561a5deb559c43
+	}},
+	{{
+		0xfcc239ba5cb83e19, 0xd6a3d0967c94fedc, 0xfca64e00b11aceac,
+		0x6f89416f5a718cd1, 0x8137e629bff2991f, 0x0b2962fe57a3225e
+	}},
+	{{
+		0x130de8938dc62cd8, 0x4976d5243eecf5c4, 0x54cca8abc28d6fd0,
+		0x5b08243f16b16551, 0xc83aafef7c40eb54, 0x03425581a58ae2fe
+	}},
+	{{
+		0x539d395b3532a21e, 0x9bd29ba81f35781d, 0x8d6b44e833b306da,
+		0xffdfc759a12062bb, 0x0a6f1d5f43e7a07d, 0x13a8e162022914a8
+	}},
+	{{
+		0xc02df9a29f6304a5, 0x7400d24bc4228f11, 0x0a43bcef24b8982f,
+		0x395735e9ce9cad4d, 0x55390f7f0506c6e9, 0x0e7355f8e4e667b9
+	}},
+	{{
+		0xec2574496ee84a3a, 0xea73b3538f0de06c, 0x4e2e073062aede9c,
+		0x570f5799af53a189, 0x0f3e0c63e0596721, 0x0772caacf1693619
+	}},
+	{{
+		0x11f7d99bbdcc5a5e, 0x0fa5b9489d11e2d3, 0x1996e1cdf9822c58,
+		0x6e7f63c21bca68a8, 0x30b3f5b074cf0199, 0x14a7ac2a9d64a8b2
+	}},
+	{{
+		0x4776ec3a79a1d641, 0x03826692abba4370, 0x74100da67f398835,
+		0xe07f8d1d7161366b, 0x5e920b3dafc7a3cc, 0x0a10ecf6ada54f82
+	}},
+	{{
+		0x2d6384d168ecdd0a, 0x93174e4b4b786500, 0x76df533978f31c15,
+		0xf682b4ee96f7d037, 0x476d6e3eb3a56680, 0x095fc13ab9e92ad4
+	}}
+};
+
+BigInt<6> constexpr c_g1IsoYNum[] = {
+	{{
+		0xbe9845719707bb33, 0xcd0c7aee9b3ba3c2, 0x2b52af6c956543d3,
+		0x11ad138e48a86952, 0x259d1f094980dcfa, 0x090d97c81ba24ee0
+	}},
+	{{
+		0xe097e75a2e41c696, 0xd6c56711962fa8bf, 0x0f906343eb67ad34,
+		0x1223e96c254f383d, 0xd51036d776fb4683, 0x134996a104ee5811
+	}},
+	{{
+		0xb8dfe240c72de1f6, 0xd26d521628b00523, 0xc344be4b91400da7,
+		0x2552e2d658a31ce2, 0xf4a384c86a3b4994, 0x00cc786baa966e66
+	}},
+	{{
+		0xa6355c77b0e5f4cb, 0xde405aba9ec61dec, 0x09e4a3ec03251cf9,
+		0xd42aa7b90eeb791c, 0x7898751ad8746757, 0x01f86376e8981c21
+	}},
+	{{
+		0x41b6daecf2e8fedb, 0x2ee7f8dc099040a8, 0x79833fd221351adc,
+		0x195536fbe3ce50b8, 0x5caf4fe2a21529c4, 0x08cc03fdefe0ff13
+	}},
+	{{
+		0x99b23ab13633a5f0, 0x203f6326c95a8072, 0x76505c3d3ad5544e,
+		0x74a7d0d4afadb7bd, 0x2211e11db8f0a6a0, 0x16603fca40634b6a
+	}},
+	{{
+		0xc961f8855fe9d6f2, 0x47a87ac2460f415e, 0x5231413c4d634f37,
+		0xe75bb8ca2be184cb, 0xb2c977d027796b3c, 0x04ab0b9bcfac1bbc
+	}},
+	{{
+		0xa15e4ca31870fb29, 0x42f64550fedfe935, 0xfd038da6c26c8426,
+		0x170a05bfe3bdd81f, 0xde9926bd2ca6c674, 0x0987c8d5333ab86f
+	}},
+	{{
+		0x60370e577bdba587, 0x69d65201c78607a3, 0x1e8b6e6a1f20cabe,
+		0x8f3abd16679dc26c, 0xe88c9e221e4da1bb, 0x09fc4018bd96684b
+	}},
+	{{
+		0x2bafaaebca731c30, 0x9b3f7055dd4eba6f, 0x06985e7ed1e4d43b,
+		0xc42a0ca7915af6fe, 0x223abde7ada14a23, 0x0e1bba7a1186bdb5
+	}},
+	{{
+		0xe813711ad011c132, 0x31bf3a5cce3fbafc, 0xd1183e416389e610,
+		0xcd2fcbcb6caf493f, 0x0dfd0b8f1d43fb93, 0x19713e47937cd1be
+	}},
+	{{
+		0xce07c8a4d0074d8e, 0x49d9cdf41b44d606, 0x2e6bfe7f911f6432,
+		0x523559b8aaf0c246, 0xb918c143fed2edcc, 0x18b46a908f36f6de
+	}},
+	{{
+		0x0d4c04f00b971ef8, 0x06c851c1919211f2, 0xc02710e807b4633f,
+		0x7aa7b12a3426b08e, 0xd155096004f53f44, 0x0b182cac101b9399
+	}},
+	{{
+		0x42d9d3f5db980133, 0xc6cf90ad1c232a64, 0x13e6632d3c40659c,
+		0x757b3b080d4c1580, 0x72fc00ae7be315dc, 0x0245a394ad1eca9b
+	}},
+	{{
+		0x866b1e715475224b, 0x6ba1049b6579afb7, 0xd9ab0f5d396a7ce4,
+		0x5e673d81d7e86568, 0x02a159f748c4a3fc, 0x05c129645e44cf11
+	}},
+	{{
+		0x04b456be69c8b604, 0xb665027efec01c77, 0x57add4fa95af01b2,
+		0xcb181d8f84965a39, 0x4ea50b3b42df2eb5, 0x15e6be4e990f03ce
+	}}
+};
+
+BigInt<6> constexpr c_g1IsoYDen[] = {
+	{{
+		0x01479253b03663c1, 0x07f3688ef60c206d, 0xeec3232b5be72e7a,
+		0x601a6de578980be6, 0x52181140fad0eae9, 0x16112c4c3a9c98b2
+	}},
+	{{
+		0x32f6102c2e49a03d, 0x78a4260763529e35, 0xa4a10356f453e01f,
+		0x85c84ff731c4d59c, 0x1a0cbd6c43c348b8, 0x1962d75c2381201e
+	}},
+	{{
+		0x1e2538b53dbf67f2, 0xa6757cd636f96f89, 0x0c35a5dd279cd2ec,
+		0x78c4855551ae7f31, 0x6faaae7d6e8eb157, 0x058df3306640da27
+	}},
+	{{
+		0xa8d26d98445f5416, 0x727364f2c28297ad, 0x123da489e726af41,
+		0xd115c5dbddbcd30e, 0xf20d23bf89edb4d1, 0x16b7d288798e5395
+	}},
+	{{
+		0xda39142311a5001d, 0xa20b15dc0fd2eded, 0x542eda0fc9dec916,
+		0xc6d19c9f0f69bbb0, 0xb00cc912f8228ddc, 0x0be0e079545f43e4
+	}},
+	{{
+		0x02c6477faaf9b7ac, 0x49f38db9dfa9cce2, 0xc5ecd87b6f0f5a64,
+		0xb70152c65550d881, 0x9fb266eaac783182, 0x08d9e5297186db2d
+	}},
+	{{
+		0x3d1a1399126a775c, 0xd5fa9c01a58b1fb9, 0x5dd365bc400a0051,
+		0x5eecfdfa8d0cf8ef, 0xc3ba8734ace9824b, 0x166007c08a99db2f
+	}},
+	{{
+		0x60ee415a15812ed9, 0xb920f5b00801dee4, 0xfeb34fd206357132,
+		0xe5a4375efa1f4fd7, 0x03bcddfabba6ff6e, 0x16a3ef08be3ea7ea
+	}},
+	{{
+		0x6b233d9d55535d4a, 0x52cfe2f7bb924883, 0xabc5750c4bf39b48,
+		0xf9fb0ce4c6af5920, 0x1a1be54fd1d74cc4, 0x1866c8ed336c6123
+	}},
+	{{
+		0x346ef48bb8913f55, 0xc7385ea3d529b35e, 0x5308592e7ea7d4fb,
+		0x3216f763e13d87bb, 0xea820597d94a8490, 0x167a55cda70a6e1c
+	}},
+	{{
+		0x00f8b49cba8f6aa8, 0x71a5c29f4f830604, 0x0e591b36e636a5c8,
+		0x9c6dd039bb61a629, 0x48f010a01ad2911d, 0x04d2f259eea405bd
+	}},
+	{{
+		0x9684b529e2561092, 0x16f968986f7ebbea, 0x8c0f9a88cea79135,
+		0x7f94ff8aefce42d2, 0xf5852c1e48c50c47, 0x0accbb67481d033f
+	}},
+	{{
+		0x1e99b138573345cc, 0x93000763e3b90ac1, 0x7d5ceef9a00d9b86,
+		0x543346d98adf0226, 0xc3613144b45f1496, 0x0ad6b9514c767fe3
+	}},
+	{{
+		0xd1fadc1326ed06f7, 0x420517bd8714cc80, 0xcb748df27942480e,
+		0xbf565b94e72927c1, 0x628bdd0d53cd76f2, 0x02660400eb2e4f3b
+	}},
+	{{
+		0x4415473a1d634b8f, 0x5ca2f570f1349780, 0x324efcd6356caa20,
+		0x71c40f65e273b853, 0x6b24255e0d7819c1, 0x0e0fa1d816ddc03e
+	}}
+};
+
+BigInt<6> constexpr c_g2IsoXNum[][2] = {
+	{
+		{{
+			0x6238aaaaaaaa97d6, 0x5c2638e343d9c71c, 0x88b58423c50ae15d,
+			0x32c52d39fd3a042a, 0xbb5b7a9a47d7ed85, 0x05c759507e8e333e
+		}},
+		{{
+			0x6238aaaaaaaa97d6, 0x5c2638e343d9c71c, 0x88b58423c50ae15d,
+			0x32c52d39fd3a042a, 0xbb5b7a9a47d7ed85, 0x05c759507e8e333e
+		}}
+	},
+	{
+		{{
+			0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+			0x0000000000000000, 0x0000000000000000, 0x0000000000000000
+		}},
+		{{
+			0x26a9ffffffffc71a, 0x1472aaa9cb8d5555, 0x9a208c6b4f20a418,
+			0x984f87adf7ae0c7f, 0x32126fced787c88f, 0x11560bf17baa99bc
+		}}
+	},
+	{
+		{{
+			0x26a9ffffffffc71e, 0x1472aaa9cb8d5555, 0x9a208c6b4f20a418,
+			0x984f87adf7ae0c7f, 0x32126fced787c88f, 0x11560bf17baa99bc
+		}},
+		{{
+			0x9354ffffffffe38d, 0x0a395554e5c6aaaa, 0xcd104635a790520c,
+			0xcc27c3d6fbd7063f, 0x190937e76bc3e447, 0x08ab05f8bdd54cde
+		}}
+	},
+	{
+		{{
+			0x88e2aaaaaaaa5ed1, 0x7098e38d0f671c71, 0x22d6108f142b8575,
+			0xcb14b4e7f4e810aa, 0xed6dea691f5fb614, 0x171d6541fa38ccfa
+		}},
+		{{
+			0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+			0x0000000000000000, 0x0000000000000000, 0x0000000000000000
+		}}
+	}
+};
+
+BigInt<6> constexpr c_g2IsoXDen[][2] = {
+	{
+		{{
+			0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+			0x0000000000000000, 0x0000000000000000, 0x0000000000000000
+		}},
+		{{
+			0xb9feffffffffaa63, 0x1eabfffeb153ffff, 0x6730d2a0f6b0f624,
+			0x64774b84f38512bf, 0x4b1ba7b6434bacd7, 0x1a0111ea397fe69a
+		}}
+	},
+	{
+		{{
+			0x000000000000000c, 0x0000000000000000, 0x0000000000000000,
+			0x0000000000000000, 0x0000000000000000, 0x0000000000000000
+		}},
+		{{
+			0xb9feffffffffaa9f, 0x1eabfffeb153ffff, 0x6730d2a0f6b0f624,
+			0x64774b84f38512bf, 0x4b1ba7b6434bacd7, 0x1a0111ea397fe69a
+		}}
+	}
+};
+
+BigInt<6> constexpr c_g2IsoYNum[][2] = {
+	{
+		{{
+			0x12cfc71c71c6d706, 0xfc8c25ebf8c92f68, 0xf54439d87d27e500,
+			0x0f7da5d4a07f649b, 0x59a4c18b076d1193, 0x1530477c7ab4113b
+		}},
+		{{
+			0x12cfc71c71c6d706, 0xfc8c25ebf8c92f68, 0xf54439d87d27e500,
+			0x0f7da5d4a07f649b, 0x59a4c18b076d1193, 0x1530477c7ab4113b
+		}}
+	},
+	{
+		{{
+			0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+			0x0000000000000000, 0x0000000000000000, 0x0000000000000000
+		}},
+		{{
+			0x6238aaaaaaaa97be, 0x5c2638e343d9c71c, 0x88b58423c50ae15d,
+			0x32c52d39fd3a042a, 0xbb5b7a9a47d7ed85, 0x05c759507e8e333e
+		}}
+	},
+	{
+		{{
+			0x26a9ffffffffc71c, 0x1472aaa9cb8d5555, 0x9a208c6b4f20a418,
+			0x984f87adf7ae0c7f, 0x32126fced787c88f, 0x11560bf17baa99bc
+		}},
+		{{
+			0x9354ffffffffe38f, 0x0a395554e5c6aaaa, 0xcd104635a790520c,
+			0xcc27c3d6fbd7063f, 0x190937e76bc3e447, 0x08ab05f8bdd54cde
+		}}
+	},
+	{
+		{{
+			0xe1b371c71c718b10, 0x4e79097a56dc4bd9, 0xb0e977c69aa27452,
+			0x761b0f37a1e26286, 0xfbf7043de3811ad0, 0x124c9ad43b6cf79b
+		}},
+		{{
+			0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+			0x0000000000000000, 0x0000000000000000, 0x0000000000000000
+		}}
+	}
+};
+
+BigInt<6> constexpr c_g2IsoYDen[][2] = {
+	{
+		{{
+			0xb9feffffffffa8fb, 0x1eabfffeb153ffff, 0x6730d2a0f6b0f624,
+			0x64774b84f38512bf, 0x4b1ba7b6434bacd7, 0x1a0111ea397fe69a
+		}},
+		{{
+			0xb9feffffffffa8fb, 0x1eabfffeb153ffff, 0x6730d2a0f6b0f624,
+			0x64774b84f38512bf, 0x4b1ba7b6434bacd7, 0x1a0111ea397fe69a
+		}}
+	},
+	{
+		{{
+			0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+			0x0000000000000000, 0x0000000000000000, 0x0000000000000000
+		}},
+		{{
+			0xb9feffffffffa9d3, 0x1eabfffeb153ffff, 0x6730d2a0f6b0f624,
+			0x64774b84f38512bf, 0x4b1ba7b6434bacd7, 0x1a0111ea397fe69a
+		}}
+	},
+	{
+		{{
+			0x0000000000000012, 0x0000000000000000, 0x0000000000000000,
+			0x0000000000000000, 0x0000000000000000, 0x0000000000000000
+		}},
+		{{
+			0xb9feffffffffaa99, 0x1eabfffeb153ffff, 0x6730d2a0f6b0f624,
+			0x64774b84f38512bf, 0x4b1ba7b6434bacd7, 0x1a0111ea397fe69a
+		}}
+	}
+};
+
+/// Constants of the simplified SWU map to y^2 = x^3 + A x + B with the
+/// non-square Z of RFC 9380: -B / A and B / (Z A), the value x1 takes for
+/// the exceptional inputs.
+template <class Field>
+struct SswuCurve
+{
+	SswuCurve(Field const& _a, Field const& _b, Field const& _z):
+		a(_a), b(_b), z(_z), minusBOverA(-(_b * _a.inverse())), bOverZA(_b * (_z * _a).inverse())
+	{}
+
+	Field a;
+	Field b;
+	Field z;
+	Field minusBOverA;
+	Field bOverZA;
+};
+
+/// x' = xNum(x) / xDen(x) and y' = y yNum(x) / yDen(x) with monic
+/// denominators, whose leading coefficients are not stored.
+template <class Field>
+struct IsogenyMap
+{
+	std::vector<Field> xNum;
+	std::vector<Field> xDen;
+	std::vector<Field> yNum;
+	std::vector<Field> yDen;
+};
+
+template <size_t N>
+vector<Fq> toFq(BigInt<6> const (&_c)[N])
+{
+	vector<Fq> r;
+	for (auto const& c: _c)
+		r.push_back(Fq::reduce(c));
+	return r;
+}
+
+template <size_t N>
+vector<Fq2> toFq2(BigInt<6> const (&_c)[N][2])
+{
+	vector<Fq2> r;
+	for (auto const& c: _c)
+		r.push_back(Fq2(Fq::reduce(c[0]), Fq::reduce(c[1])));
+	return r;
+}
+
+struct Constants
+{
+	Constants():
+		xi(Fq(1), Fq(1)),
+		twoInv(Fq(2).inverse()),
+		twistB(Fq2(Fq(4), Fq(4))),
+		twistMulByQX(xi.pow(bigint::divSmall(bigint::subSmall(Fq::c_modulus, 1), 3)).inverse()),
+		twistMulByQY(xi.pow(bigint::divSmall(bigint::subSmall(Fq::c_modulus, 1), 2)).inverse()),
+		frobenius(xi.pow(bigint::divSmall(bigint::subSmall(Fq::c_modulus, 1), 6))),
+		beta(Fq::reduce(c_beta)),
+		g1Sswu(Fq::reduce(c_g1SswuA), Fq::reduce(c_g1SswuB), Fq(11)),
+		g2Sswu(Fq2(Fq::zero(), Fq(240)), Fq2(Fq(1012), Fq(1012)), -Fq2(Fq(2), Fq(1))),
+		g1Iso{toFq(c_g1IsoXNum), toFq(c_g1IsoXDen), toFq(c_g1IsoYNum), toFq(c_g1IsoYDen)},
+		g2Iso{toFq2(c_g2IsoXNum), toFq2(c_g2IsoXDen), toFq2(c_g2IsoYNum), toFq2(c_g2IsoYDen)}
+	{}
+
+	Fq2 xi;
+	Fq twoInv;
+	Fq2 twistB;
+	/// Coefficients of the untwist-Frobenius-twist endomorphism, inverted
+	/// because the twist is of M-type.
+	Fq2 twistMulByQX;
+	Fq2 twistMulByQY;
+	TowerFrobenius<TowerConfig> frobenius;
+	Fq beta;
+	/// The curves 11-isogenous to E and 3-isogenous to the twist of RFC 9380
+	/// sections 8.8.1 and 8.8.2 and the isogenies from them.
+	SswuCurve<Fq> g1Sswu;
+	SswuCurve<Fq2> g2Sswu;
+	IsogenyMap<Fq> g1Iso;
+	IsogenyMap<Fq2> g2Iso;
+};
+
+Constants const& constants()
+{
+	static Constants const s_constants;
+	return s_constants;
+}
+
+/// Doubling step in homogeneous projective coordinates with the tangent line
+/// (Aranha et al., "Faster explicit formulas for computing pairings over
+/// ordinary curves"). On an M-type twist the constant term needs no factor xi.
+EllCoeffs doublingStep(G2& io_r)
+{
+	Constants const& c = constants();
+	Fq2 const& x = io_r.x;
+	Fq2 const& y = io_r.y;
+	Fq2 const& z = io_r.z;
+	Fq2 const a = (x * y) * c.twoInv;
+	Fq2 const b = y.squared();
+	Fq2 const cc = z.squared();
+	Fq2 const d = cc.dbl() + cc;
+	Fq2 const e = c.twistB * d;
+	Fq2 const f = e.dbl() + e;
+	Fq2 const g = (b + f) * c.twoInv;
+	Fq2 const h = (y + z).squared() - (b + cc);
+	Fq2 const i = e - b;
+	Fq2 const j = x.squared();
+	Fq2 const e2 = e.squared();
+
+	EllCoeffs coeffs{i, -h, j.dbl() + j};
+	io_r = G2(a * (b - f), g.squared() - (e2.dbl() + e2), b * h);
+	return coeffs;
+}
+
+/// Mixed addition step of the affine point @a _q with the chord line.
+EllCoeffs additionStep(G2 const& _q, G2& io_r)
+{
+	Fq2 const& x1 = io_r.x;
+	Fq2 const& y1 = io_r.y;
+	Fq2 const& z1 = io_r.z;
+	Fq2 const d = x1 - _q.x * z1;
+	Fq2 const e = y1 - _q.y * z1;
+	Fq2 const f = d.squared();
+	Fq2 const g = e.squared();
+	Fq2 const h = d * f;
+	Fq2 const i = x1 * f;
+	Fq2 const j = h + z1 * g - i.dbl();
+
+	EllCoeffs coeffs{e * _q.x - d * _q.y, d, -e};
+	io_r = G2(d * j, e * (i - j) - h * y1, z1 * h);
+	return coeffs;
+}
+
+Fq12 evaluate(Fq12 const& _f, EllCoeffs const& _c, G1 const& _p)
+{
+	return _f.mulBy014(_c.ell0, _c.ellVV * _p.x, _c.ellVW * _p.y);
+}
+
+/// f^z for an element of the cyclotomic subgroup.
+Fq12 expByZ(Fq12 const& _f)
+{
+	return _f.cyclotomicExp(c_z).unitaryInverse();
+}
+
+/// f^((p^6 - 1)(p^2 + 1))
+Fq12 finalExponentiationFirstChunk(Fq12 const& _f)
+{
+	Fq12 const a = _f.unitaryInverse() * _f.inverse();
+	return a.frobeniusMap(2) * a;
+}
+
+/// Hard part to the power 3 (p^4 - p^2 + 1) / r
+/// = (z - 1)^2 (z + p) (z^2 + p^2 - 1) + 3
+/// (Hayashida, Hayasaka and Teruya, "Efficient final exponentiation via
+/// cyclotomic structure for pairings over families of elliptic curves").
+Fq12 finalExponentiationLastChunk(Fq12 const& _f)
+{
+	Fq12 const fInv = _f.unitaryInverse();
+	Fq12 const a = expByZ(_f) * fInv;
+	Fq12 const b = expByZ(a) * a.unitaryInverse();
+	Fq12 const c = expByZ(b) * b.frobeniusMap(1);
+	Fq12 const d = expByZ(expByZ(c)) * c.frobeniusMap(2) * c.unitaryInverse();
+	return d * _f.cyclotomicSquared() * _f;
+}
+
+/// [|z|]P by double-and-add, which for the six set bits of |z| is cheaper
+/// than the NAF of JacobianPoint::mul with its table.
+template <class Point>
+Point mulByAbsZ(Point const& _p)
+{
+	Point r = _p;
+	for (size_t i = c_z.numBits() - 1; i-- > 0;)
+	{
+		r = r.dbl();
+		if (c_z.testBit(i))
+			r += _p;
+	}
+	return r;
+}
+
+/// [z]P for the negative BLS parameter z.
+template <class Point>
+Point mulByZ(Point const& _p)
+{
+	return -mulByAbsZ(_p);
+}
+
+bool isSquare(Fq const& _x)
+{
+	return _x.isSquare();
+}
+
+/// An element of Fq2 is a square iff its norm is a square in Fq.
+bool isSquare(Fq2 const& _x)
+{
+	return (_x.c0.squared() + _x.c1.squared()).isSquare();
+}
+
+/// sgn0 of RFC 9380 section 4.1.
+bool sgn0(Fq const& _x)
+{
+	return _x.isOdd();
+}
+
+bool sgn0(Fq2 const& _x)
+{
+	return _x.c0.isOdd() | (_x.c0.isZero() & _x.c1.isOdd());
+}
+
+Fq select(bool _condition, Fq const& _ifTrue, Fq const& _ifFalse)
+{
+	return Fq::select(_condition, _ifTrue, _ifFalse);
+}
+
+Fq2 select(bool _condition, Fq2 const& _ifTrue, Fq2 const& _ifFalse)
+{
+	return Fq2(Fq::select(_condition, _ifTrue.c0, _ifFalse.c0), Fq::select(_condition, _ifTrue.c1, _ifFalse.c1));
+}
+
+/// Evaluates the polynomial of coefficients @a _c, lowest degree first, with
+/// a further leading coefficient one if @a _monic.
+template <class Field>
+Field evaluatePolynomial(vector<Field> const& _c, Field const& _x, bool _monic)
+{
+	size_t i = _c.size();
+	Field r = _monic ? Field::one() : _c[--i];
+	while (i-- > 0)
+		r = r * _x + _c[i];
+	return r;
+}
+
+/// Simplified SWU map of RFC 9380 section 6.6.2 to @a _curve followed by the
+/// isogeny @a _iso, with the one inversion per element batched.
+template <class Point, class Field>
+void mapToCurve(SswuCurve<Field> const& _curve, IsogenyMap<Field> const& _iso, Field const* _u, size_t _count, Point* o_points)
+{
+	auto curve = [&](Field const& _x) { return (_x.squared() + _curve.a) * _x + _curve.b; };
+
+	// inv0 maps zero to zero, which makes x1 = B / (Z A) for the exceptional
+	// inputs; their denominators are replaced by one before inverting.
+	vector<Field> zu2(_count);
+	vector<Field> tv1(_count);
+	vector<uint8_t> zeroDenominator(_count);
+	for (size_t i = 0; i < _count; ++i)
+	{
+		zu2[i] = _curve.z * _u[i].squared();
+		Field const d = zu2[i].squared() + zu2[i];
+		zeroDenominator[i] = d.isZero();
+		tv1[i] = select(zeroDenominator[i], Field::one(), d);
+	}
+	batchInvert(tv1);
+
+	for (size_t i = 0; i < _count; ++i)
+	{
+		Field const x1 = select(zeroDenominator[i], _curve.bOverZA, _curve.minusBOverA * (Field::one() + tv1[i]));
+		Field const gx1 = curve(x1);
+		Field const x2 = zu2[i] * x1;
+		bool const e1 = isSquare(gx1);
+		Field const x = select(e1, x1, x2);
+		Field y;
+		select(e1, gx1, curve(x2)).sqrt(y);
+		y = select(sgn0(_u[i]) == sgn0(y), y, -y);
+
+		// The image (xNum / xDen, y yNum / yDen) in Jacobian coordinates with
+		// Z = xDen yDen; a zero denominator yields the point at infinity as
+		// required.
+		Field const xDen = evaluatePolynomial(_iso.xDen, x, true);
+		Field const yDen = evaluatePolynomial(_iso.yDen, x, true);
+		Field const t = xDen * yDen.squared();
+		o_points[i] = Point(
+			evaluatePolynomial(_iso.xNum, x, false) * t,
+			y * evaluatePolynomial(_iso.yNum, x, false) * t * xDen.squared(),
+			xDen * yDen
+		);
+	}
+}
+
+}
+
+Fq const& G1Params::b()
+{
+	static Fq const s_b(4);
+	return s_b;
+}
+
+Fq2 const& G2Params::b()
+{
+	return constants().twistB;
+}
+
+TowerFrobenius<TowerConfig> const& TowerConfig::frobenius()
+{
+	return constants().frobenius;
+}
+
+G1 const& bls12_381::g1Generator()
+{
+	static G1 const s_generator = G1::fromAffine(
+		Fq::reduce({{
+			0xfb3af00adb22c6bb, 0x6c55e83ff97a1aef, 0xa14e3a3f171bac58,
+			0xc3688c4f9774b905, 0x2695638c4fa9ac0f, 0x17f1d3a73197d794
+		}}),
+		Fq::reduce({{
+			0x0caa232946c5e7e1, 0xd03cc744a2888ae4, 0x00db18cb2c04b3ed,
+			0xfcf5e095d5d00af6, 0xa09e30ed741d8ae4, 0x08b3f481e3aaa0f1
+		}})
+	);
+	return s_generator;
+}
+
+G2 const& bls12_381::g2Generator()
+{
+	static G2 const s_generator = G2::fromAffine(
+		Fq2(
+			Fq::reduce({{
+				0xd48056c8c121bdb8, 0x0bac0326a805bbef, 0xb4510b647ae3d177,
+				0xc6e47ad4fa403b02, 0x260805272dc51051, 0x024aa2b2f08f0a91
+			}}),
+			Fq::reduce({{
+				0xe5ac7d055d042b7e, 0x334cf11213945d57, 0xb5da61bbdc7f5049,
+				0x596bd0d09920b61a, 0x7dacd3a088274f65, 0x13e02b6052719f60
+			}})
+		),
+		Fq2(
+			Fq::reduce({{
+				0xe193548608b82801, 0x923ac9cc3baca289, 0x6d429a695160d12c,
+				0xadfd9baa8cbdd3a7, 0x8cc9cdc6da2e351a, 0x0ce5d527727d6e11
+			}}),
+			Fq::reduce({{
+				0xaaa9075ff05f79be, 0x3f370d275cec1da1, 0x267492ab572e99ab,
+				0xcb3e287e85a763af, 0x32acd2b02bc28b99, 0x0606c4a02ea734cc
+			}})
+		)
+	);
+	return s_generator;
+}
+
+bool bls12_381::isInG1Subgroup(G1 const& _p)
+{
+	// P is in G1 iff (beta x, y) == [-z^2]P (Scott, "A note on group
+	// membership tests for G1, G2 and GT on BLS pairing-friendly curves",
+	// section 6).
+	G1 const sigma(constants().beta * _p.x, _p.y, _p.z);
+	return sigma == -mulByAbsZ(mulByAbsZ(_p));
+}
+
+bool bls12_381::isInG2Subgroup(G2 const& _q)
+{
+	// Q is in G2 iff psi(Q) == [z]Q (ibid., section 4).
+	return psi(_q) == mulByZ(_q);
+}
+
+G2 bls12_381::psi(G2 const& _q)
+{
+	// The Frobenius map commutes with the Jacobian coordinate scaling.
+	Constants const& c = constants();
+	return G2(c.twistMulByQX * _q.x.conjugate(), c.twistMulByQY * _q.y.conjugate(), _q.z.conjugate());
+}
+
+void bls12_381::mapToG1(Fq const* _u, size_t _count, G1* o_points)
+{
+	Constants const& c = constants();
+	mapToCurve(c.g1Sswu, c.g1Iso, _u, _count, o_points);
+	// h_eff = 1 - z = 1 + |z|
+	for (size_t i = 0; i < _count; ++i)
+		o_points[i] = o_points[i] + mulByAbsZ(o_points[i]);
+}
+
+void bls12_381::mapToG2(Fq2 const* _u, size_t _count, G2* o_points)
+{
+	Constants const& c = constants();
+	mapToCurve(c.g2Sswu, c.g2Iso, _u, _count, o_points);
+	// h_eff P = [z^2 - z - 1]P + [z - 1]psi(P) + psi^2(2P) (Budroni and
+	// Pintore), evaluated as in RFC 9380 appendix G.3.
+	for (size_t i = 0; i < _count; ++i)
+	{
+		G2 const& p = o_points[i];
+		G2 const t1 = mulByZ(p);
+		G2 const t2 = psi(p);
+		G2 const t3 = psi(psi(p.dbl())) + -t2;
+		o_points[i] = t3 + mulByZ(t1 + t2) + -t1 + -p;
+	}
+}
+
+G2Prepared bls12_381::prepareG2(G2 const& _q)
+{
+	G2Prepared result;
+	G2 r = _q;
+	for (size_t i = c_z.numBits() - 1; i-- > 0;)
+	{
+		result.coeffs.push_back(doublingStep(r));
+		if (c_z.testBit(i))
+			result.coeffs.push_back(additionStep(_q, r));
+	}
+	return result;
+}
+
+Fq12 bls12_381::multiMillerLoop(G1 const* _p, G2Prepared const* const* _q, size_t _count)
+{
+	Fq12 f = Fq12::one();
+	size_t idx = 0;
+	for (size_t i = c_z.numBits() - 1; i-- > 0;)
+	{
+		f = f.squared();
+		for (size_t k = 0; k < _count; ++k)
+			f = evaluate(f, _q[k]->coeffs[idx], _p[k]);
+		++idx;
+		if (c_z.testBit(i))
+		{
+			for (size_t k = 0; k < _count; ++k)
+				f = evaluate(f, _q[k]->coeffs[idx], _p[k]);
+			++idx;
+		}
+	}
+	// z is negative.
+	return f.unitaryInverse();
+}
+
+Fq12 bls12_381::multiMillerLoop(G1 const* _p, G2Prepared const* _q, size_t _count)
+{
+	vector<G2Prepared const*> q(_count);
+	for (size_t k = 0; k < _count; ++k)
+		q[k] = &_q[k];
+	return multiMillerLoop(_p, q.data(), _count);
+}
+
+Fq12 bls12_381::multiMillerLoopSkippingZero(G1* io_p, G2Prepared const** io_q, size_t _count)
+{
+	return multiMillerLoop(io_p, io_q, compactPairs(io_p, io_q, _count));
+}
+
+Fq12 bls12_381::finalExponentiation(Fq12 const& _f)
+{
+	return finalExponentiationLastChunk(finalExponentiationFirstChunk(_f));
+}
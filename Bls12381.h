@@ -0,0 +1,139 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2014-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+/** @file Bls12381.h
+ * Native arithmetic of the BLS12-381 pairing-friendly curve.
+ *
+ * E: y^2 = x^3 + 4 over Fq, the M-type twist E': y^2 = x^3 + 4 xi over Fq2
+ * with xi = 1 + u, and the optimal ate pairing e: G1 x G2 -> Fq12.
+ */
+
+#pragma once
+
+#include "EllipticCurve.h"
+#include "Montgomery.h"
+#include "Tower.h"
+
+#include <vector>
+
+namespace dev
+{
+namespace crypto
+{
+namespace bls12_381
+{
+
+struct FqParams
+{
+	static constexpr size_t limbs = 6;
+	static constexpr BigInt<6> modulus()
+	{
+		return {{
+			0xb9feffffffffaaab, 0x1eabfffeb153ffff, 0x6730d2a0f6b0f624,
+			0x64774b84f38512bf, 0x4b1ba7b6434bacd7, 0x1a0111ea397fe69a
+		}};
+	}
+};
+
+struct FrParams
+{
+	static constexpr size_t limbs = 4;
+	static constexpr BigInt<4> modulus()
+	{
+		return {{0xffffffff00000001, 0x53bda402fffe5bfe, 0x3339d80809a1d805, 0x73eda753299d7d48}};
+	}
+};
+
+/// Base field.
+using Fq = MontgomeryField<FqParams>;
+/// Scalar field, i.e. integers modulo the group order r.
+using Fr = MontgomeryField<FrParams>;
+using Fq2 = Fp2T<Fq>;
+
+struct TowerConfig
+{
+	using Fp = Fq;
+	using Fp2 = Fq2;
+
+	/// Multiplication by xi = 1 + u.
+	static Fq2 mulByXi(Fq2 const& _a) { return Fq2(_a.c0 - _a.c1, _a.c0 + _a.c1); }
+
+	static TowerFrobenius<TowerConfig> const& frobenius();
+};
+
+using Fq6 = Fp6T<TowerConfig>;
+using Fq12 = Fp12T<TowerConfig>;
+
+struct G1Params
+{
+	static Fq const& b();
+};
+
+struct G2Params
+{
+	static Fq2 const& b();
+};
+
+using G1 = JacobianPoint<Fq, G1Params>;
+using G2 = JacobianPoint<Fq2, G2Params>;
+
+/// Group order r.
+inline Fr::Int const& order() { return Fr::c_modulus; }
+
+G1 const& g1Generator();
+G2 const& g2Generator();
+
+/// @returns true if @a _p lies in the order r subgroup of E.
+bool isInG1Subgroup(G1 const& _p);
+/// @returns true if @a _q lies in the order r subgroup of the twist.
+bool isInG2Subgroup(G2 const& _q);
+
+/// The untwist-Frobenius-twist endomorphism psi, which acts on G2 as
+/// multiplication by p mod r = z.
+G2 psi(G2 const& _q);
+
+/// Simplified SWU map of RFC 9380 to the curve 11-isogenous to E, followed by
+/// the isogeny and the clearing of the cofactor with h_eff = 1 - z: the
+/// MAP_FP_TO_G1 operation of EIP-2537. The inversions of all @a _count
+/// elements are batched and the results are in G1.
+void mapToG1(Fq const* _u, size_t _count, G1* o_points);
+/// The same for G2 with the 3-isogenous curve and the cofactor clearing of
+/// RFC 9380 appendix G.3 (MAP_FP2_TO_G2). Unlike the map to G1, the square
+/// root in Fq2 branches on its input.
+void mapToG2(Fq2 const* _u, size_t _count, G2* o_points);
+
+/// Coefficients of one line function of the Miller loop, evaluated at P as
+/// ell0 + ellVV * xP w^2 + ellVW * yP w^3.
+struct EllCoeffs
+{
+	Fq2 ell0;
+	Fq2 ellVW;
+	Fq2 ellVV;
+};
+
+/// The line functions of the Miller loop for a fixed G2 point.
+struct G2Prepared
+{
+	std::vector<EllCoeffs> coeffs;
+};
+
+/// Precomputes the Miller loop lines of a non-zero G2 point in affine form.
+G2Prepared prepareG2(G2 const& _q);
+
+/// Product of the Miller loops of @a _count pairs (_p[i], _q[i]) sharing the
+/// squarings of the accumulator. The G1 points must be non-zero and affine.
+Fq12 multiMillerLoop(G1 const* _p, G2Prepared const* const* _q, size_t _count);
+Fq12 multiMillerLoop(G1 const* _p, G2Prepared const* _q, size_t _count);
+/// Same for G1 points in any form: converts them to affine form and skips
+/// the pairs with a zero point, which contribute a factor of one. Overwrites
+/// @a io_p and @a io_q.
+Fq12 multiMillerLoopSkippingZero(G1* io_p, G2Prepared const** io_q, size_t _count);
+
+/// Raises to the power 3 (p^12 - 1) / r. The factor 3 is coprime to r, so the
+/// result is still a non-degenerate bilinear pairing and pairing checks are
+/// unaffected.
+Fq12 finalExponentiation(Fq12 const& _f);
+
+}
+}
+}
@@ -0,0 +1,217 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2014-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+
+#include <libdevcrypto/Bls12381Precompiles.h>
+#include <libdevcrypto/Bls12381.h>
+#include <libdevcrypto/MultiScalarMul.h>
+
+#include <libdevcore/FixedHash.h>
+
+using namespace std;
+using namespace dev;
+using namespace dev::crypto;
+using namespace dev::crypto::bls12_381;
+
+namespace
+{
+
+size_t constexpr c_fieldSize = 64;
+size_t constexpr c_g1Size = 2 * c_fieldSize;
+size_t constexpr c_g2Size = 4 * c_fieldSize;
+size_t constexpr c_scalarSize = 32;
+
+using Scalar = BigInt<4>;
+
+/// @returns false if the padding is not zero or the number is not smaller than p.
+bool decodeFqElement(bytesConstRef _data, Fq& o_x)
+{
+	Fq::Int v;
+	return v.fromBigEndian(_data.data(), c_fieldSize) && Fq::fromCanonical(v, o_x);
+}
+
+bool decodeFq2Element(bytesConstRef _data, Fq2& o_x)
+{
+	return
+		decodeFqElement(_data.cropped(0, c_fieldSize), o_x.c0) &&
+		decodeFqElement(_data.cropped(c_fieldSize, c_fieldSize), o_x.c1);
+}
+
+/// @returns false if the encoding is invalid or the point is not on the curve.
+template <class Point, class Field>
+bool decodePoint(bytesConstRef _data, bool (*_decodeField)(bytesConstRef, Field&), Point& o_p)
+{
+	size_t const half = _data.size() / 2;
+	Field x;
+	Field y;
+	if (!_decodeField(_data.cropped(0, half), x) || !_decodeField(_data.cropped(half, half), y))
+		return false;
+	if (x.isZero() && y.isZero())
+	{
+		o_p = Point::zero();
+		return true;
+	}
+	o_p = Point::fromAffine(x, y);
+	return o_p.isOnCurve();
+}
+
+bool decodePointG1(bytesConstRef _data, G1& o_p)
+{
+	return decodePoint(_data.cropped(0, c_g1Size), decodeFqElement, o_p);
+}
+
+bool decodePointG2(bytesConstRef _data, G2& o_p)
+{
+	return decodePoint(_data.cropped(0, c_g2Size), decodeFq2Element, o_p);
+}
+
+void encodeFqElement(Fq const& _x, byte* o_data)
+{
+	_x.toCanonical().toBigEndian(o_data, c_fieldSize);
+}
+
+void encodeFqElement(Fq2 const& _x, byte* o_data)
+{
+	encodeFqElement(_x.c0, o_data);
+	encodeFqElement(_x.c1, o_data + c_fieldSize);
+}
+
+template <class Point>
+bytes encodePoint(Point const& _p, size_t _size)
+{
+	bytes out(_size, 0);
+	if (_p.isZero())
+		return out;
+	Point const a = _p.toAffine();
+	encodeFqElement(a.x, out.data());
+	encodeFqElement(a.y, out.data() + _size / 2);
+	return out;
+}
+
+Scalar decodeScalar(bytesConstRef _data)
+{
+	Scalar s;
+	s.fromBigEndian(_data.data(), c_scalarSize);
+	return s;
+}
+
+template <class Point>
+pair<bool, bytes> addPoints(
+	bytesConstRef _in,
+	size_t _pointSize,
+	bool (*_decode)(bytesConstRef, Point&)
+)
+{
+	if (_in.size() != 2 * _pointSize)
+		return {false, bytes{}};
+	Point p1;
+	Point p2;
+	if (!_decode(_in, p1) || !_decode(_in.cropped(_pointSize), p2))
+		return {false, bytes{}};
+	return {true, encodePoint(p1 + p2, _pointSize)};
+}
+
+template <class Point>
+pair<bool, bytes> msmPoints(
+	bytesConstRef _in,
+	size_t _pointSize,
+	bool (*_decode)(bytesConstRef, Point&),
+	bool (*_inSubgroup)(Point const&)
+)
+{
+	size_t const termSize = _pointSize + c_scalarSize;
+	size_t const terms = _in.size() / termSize;
+	if (terms == 0 || terms * termSize != _in.size())
+		// Invalid length.
+		return {false, bytes{}};
+
+	vector<Point> points;
+	vector<Scalar> scalars;
+	points.reserve(terms);
+	scalars.reserve(terms);
+	for (size_t i = 0; i < terms; ++i)
+	{
+		bytesConstRef const term = _in.cropped(i * termSize, termSize);
+		Point p;
+		if (!_decode(term, p) || !_inSubgroup(p))
+			return {false, bytes{}};
+		Scalar const s = decodeScalar(term.cropped(_pointSize));
+		if (p.isZero() || s.isZero())
+			continue;
+		points.push_back(p);
+		scalars.push_back(s);
+	}
+	return {true, encodePoint(multiScalarMul(move(points), scalars), _pointSize)};
+}
+
+}
+
+pair<bool, bytes> dev::crypto::bls12_381_G1_add(bytesConstRef _in)
+{
+	return addPoints<G1>(_in, c_g1Size, decodePointG1);
+}
+
+pair<bool, bytes> dev::crypto::bls12_381_G1_msm(bytesConstRef _in)
+{
+	return msmPoints<G1>(_in, c_g1Size, decodePointG1, isInG1Subgroup);
+}
+
+pair<bool, bytes> dev::crypto::bls12_381_G2_add(bytesConstRef _in)
+{
+	return addPoints<G2>(_in, c_g2Size, decodePointG2);
+}
+
+pair<bool, bytes> dev::crypto::bls12_381_G2_msm(bytesConstRef _in)
+{
+	return msmPoints<G2>(_in, c_g2Size, decodePointG2, isInG2Subgroup);
+}
+
+pair<bool, bytes> dev::crypto::bls12_381_pairing_check(bytesConstRef _in)
+{
+	size_t constexpr pairSize = c_g1Size + c_g2Size;
+	size_t const pairs = _in.size() / pairSize;
+	if (pairs == 0 || pairs * pairSize != _in.size())
+		// Invalid length.
+		return {false, bytes{}};
+
+	vector<G1> g1s;
+	vector<G2Prepared> g2s;
+	for (size_t i = 0; i < pairs; ++i)
+	{
+		bytesConstRef const pair = _in.cropped(i * pairSize, pairSize);
+		G1 p;
+		G2 q;
+		if (!decodePointG1(pair, p) || !decodePointG2(pair.cropped(c_g1Size), q))
+			return {false, bytes{}};
+		if (!isInG1Subgroup(p) || !isInG2Subgroup(q))
+			return {false, bytes{}};
+		if (p.isZero() || q.isZero())
+			continue; // the pairing is one
+		g1s.push_back(p);
+		g2s.push_back(prepareG2(q));
+	}
+	// All Miller loops share the squarings of a single accumulator.
+	Fq12 const x = multiMillerLoop(g1s.data(), g2s.data(), g1s.size());
+	bool const result = finalExponentiation(x).isOne();
+	return {true, h256{result}.asBytes()};
+}
+
+pair<bool, bytes> dev::crypto::bls12_381_map_fp_to_G1(bytesConstRef _in)
+{
+	Fq u;
+	if (_in.size() != c_fieldSize || !decodeFqElement(_in, u))
+		return {false, bytes{}};
+	G1 p;
+	mapToG1(&u, 1, &p);
+	return {true, encodePoint(p, c_g1Size)};
+}
+
+pair<bool, bytes> dev::crypto::bls12_381_map_fp2_to_G2(bytesConstRef _in)
+{
+	Fq2 u;
+	if (_in.size() != 2 * c_fieldSize || !decodeFq2Element(_in, u))
+		return {false, bytes{}};
+	G2 q;
+	mapToG2(&u, 1, &q);
+	return {true, encodePoint(q, c_g2Size)};
+}
@@ -0,0 +1,41 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2014-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+/** @file Bls12381Precompiles.h
+ * BLS12-381 operations with the encodings of EIP-2537.
+ *
+ * Field elements are 64 bytes: 16 zero bytes followed by the 48 byte big-endian
+ * number, which must be smaller than p. Fq2 elements are c0 followed by c1.
+ * G1 points are x || y (128 bytes), G2 points x || y (256 bytes), and the point
+ * at infinity is all zeros. Scalars are 32 byte big-endian numbers and are not
+ * required to be reduced.
+ */
+
+#pragma once
+
+#include <libdevcore/Common.h>
+
+namespace dev
+{
+namespace crypto
+{
+
+/// Input: two G1 points. Output: their sum. No subgroup check is done.
+std::pair<bool, bytes> bls12_381_G1_add(bytesConstRef _in);
+/// Input: k > 0 (G1 point, scalar) pairs. Output: sum_i scalar_i * point_i.
+std::pair<bool, bytes> bls12_381_G1_msm(bytesConstRef _in);
+/// Input: two G2 points. Output: their sum. No subgroup check is done.
+std::pair<bool, bytes> bls12_381_G2_add(bytesConstRef _in);
+/// Input: k > 0 (G2 point, scalar) pairs. Output: sum_i scalar_i * point_i.
+std::pair<bool, bytes> bls12_381_G2_msm(bytesConstRef _in);
+/// Input: k > 0 (G1 point, G2 point) pairs.
+/// Output: 1 if the product of their pairings is one, 0 otherwise (32 bytes).
+std::pair<bool, bytes> bls12_381_pairing_check(bytesConstRef _in);
+/// Input: an Fq element. Output: its image in G1 under the map of RFC 9380,
+/// simplified SWU to an isogenous curve followed by cofactor clearing.
+std::pair<bool, bytes> bls12_381_map_fp_to_G1(bytesConstRef _in);
+/// Input: an Fq2 element. Output: its image in G2 under the map of RFC 9380.
+std::pair<bool, bytes> bls12_381_map_fp2_to_G2(bytesConstRef _in);
+
+}
+}
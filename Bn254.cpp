@@ -0,0 +1,532 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2014-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+
+#include "Bn254.h"
+#include "Bn254Ifma.h"
+#include "Hash.h"
+
+#include <algorithm>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <cpuid.h>
+#endif
+
+using namespace std;
+using namespace dev;
+using namespace dev::crypto;
+using namespace dev::crypto::alt_bn128;
+
+namespace
+{
+
+bool detectAvx512Ifma()
+{
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+	unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+	// The OS has to save the opmask and ZMM registers (XCR0 bits 1, 2, 5-7).
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & (1u << 27)))
+		return false;
+	unsigned xcr0 = 0, xcr0High = 0;
+	__asm__("xgetbv" : "=a"(xcr0), "=d"(xcr0High) : "c"(0));
+	if ((xcr0 & 0xe6) != 0xe6)
+		return false;
+	if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+		return false;
+	bool const avx512f = ebx & (1u << 16);
+	bool const avx512ifma = ebx & (1u << 21);
+	return avx512f && avx512ifma;
+#else
+	return false;
+#endif
+}
+
+/// 6z + 2 for the BN parameter z = 4965661367192848881.
+BigInt<2> constexpr c_ateLoopCount{{0x9d797039be763ba8, 0x1}};
+/// The BN parameter z.
+BigInt<1> constexpr c_z{{0x44e992b44a6909f1}};
+/// 6z^2 = p mod r, the eigenvalue of psi on G2.
+BigInt<4> constexpr c_psiEigenvalue{{0xf83e9682e87cfd46, 0x6f4d8248eeb859fb, 0, 0}};
+
+struct Constants
+{
+	Constants():
+		xi(Fq(9), Fq(1)),
+		twoInv(Fq(2).inverse()),
+		twistB(Fq2(Fq(3), Fq::zero()) * xi.inverse()),
+		twistMulByQX(xi.pow(bigint::divSmall(bigint::subSmall(Fq::c_modulus, 1), 3))),
+		twistMulByQY(xi.pow(bigint::divSmall(bigint::subSmall(Fq::c_modulus, 1), 2))),
+		frobenius(xi.pow(bigint::divSmall(bigint::subSmall(Fq::c_modulus, 1), 6))),
+		svdwC2(-twoInv),
+		svdwC4(-Fq(16) * Fq(3).inverse())
+	{
+		(-Fq(12)).sqrt(svdwC3);
+		if (svdwC3.isOdd())
+			svdwC3 = -svdwC3;
+	}
+
+	Fq2 xi;
+	Fq twoInv;
+	Fq2 twistB;
+	/// Coefficients of the untwist-Frobenius-twist endomorphism.
+	Fq2 twistMulByQX;
+	Fq2 twistMulByQY;
+	TowerFrobenius<TowerConfig> frobenius;
+	/// Constants of the Shallue-van de Woestijne map of RFC 9380 with Z = 1,
+	/// g(x) = x^3 + 3 and c1 = g(Z) = 4: c2 = -Z / 2, c3 = sqrt(-g(Z) * 3Z^2)
+	/// with sgn0(c3) = 0 and c4 = -4g(Z) / 3Z^2.
+	Fq svdwC2;
+	Fq svdwC3;
+	Fq svdwC4;
+};
+
+Constants const& constants()
+{
+	static Constants const s_constants;
+	return s_constants;
+}
+
+/// Doubling step in homogeneous projective coordinates with the tangent line
+/// (Aranha et al., "Faster explicit formulas for computing pairings over
+/// ordinary curves").
+EllCoeffs doublingStep(G2& io_r)
+{
+	Constants const& c = constants();
+	Fq2 const& x = io_r.x;
+	Fq2 const& y = io_r.y;
+	Fq2 const& z = io_r.z;
+	Fq2 const a = (x * y) * c.twoInv;
+	Fq2 const b = y.squared();
+	Fq2 const cc = z.squared();
+	Fq2 const d = cc.dbl() + cc;
+	Fq2 const e = c.twistB * d;
+	Fq2 const f = e.dbl() + e;
+	Fq2 const g = (b + f) * c.twoInv;
+	Fq2 const h = (y + z).squared() - (b + cc);
+	Fq2 const i = e - b;
+	Fq2 const j = x.squared();
+	Fq2 const e2 = e.squared();
+
+	EllCoeffs coeffs{TowerConfig::mulByXi(i), -h, j.dbl() + j};
+	io_r = G2(a * (b - f), g.squared() - (e2.dbl() + e2), b * h);
+	return coeffs;
+}
+
+/// Mixed addition step of the affine point @a _q with the chord line.
+EllCoeffs additionStep(G2 const& _q, G2& io_r)
+{
+	Fq2 const& x1 = io_r.x;
+	Fq2 const& y1 = io_r.y;
+	Fq2 const& z1 = io_r.z;
+	Fq2 const d = x1 - _q.x * z1;
+	Fq2 const e = y1 - _q.y * z1;
+	Fq2 const f = d.squared();
+	Fq2 const g = e.squared();
+	Fq2 const h = d * f;
+	Fq2 const i = x1 * f;
+	Fq2 const j = h + z1 * g - i.dbl();
+
+	EllCoeffs coeffs{TowerConfig::mulByXi(e * _q.x - d * _q.y), d, -e};
+	io_r = G2(d * j, e * (i - j) - h * y1, z1 * h);
+	return coeffs;
+}
+
+/// Splits _k < r into _k = o_k0 + o_k1 * 6z^2 with o_k0 < 6z^2 by binary long
+/// division. Both parts are below 2^128.
+void splitScalar(BigInt<4> const& _k, BigInt<4>& o_k0, BigInt<4>& o_k1)
+{
+	o_k0 = BigInt<4>{};
+	o_k1 = BigInt<4>{};
+	for (size_t i = _k.numBits(); i-- > 0;)
+	{
+		bigint::add(o_k0, o_k0, o_k0);
+		o_k0.data[0] |= uint64_t(_k.testBit(i));
+		bigint::add(o_k1, o_k1, o_k1);
+		if (o_k0 >= c_psiEigenvalue)
+		{
+			bigint::sub(o_k0, o_k0, c_psiEigenvalue);
+			o_k1.data[0] |= 1;
+		}
+	}
+}
+
+Fq12 evaluate(Fq12 const& _f, EllCoeffs const& _c, G1 const& _p)
+{
+	return _f.mulBy024(_c.ell0, _c.ellVW * _p.y, _c.ellVV * _p.x);
+}
+
+/// Shared Miller loop of @a _count pairs, where _prepared(k) is the prepared
+/// G2 point of pair k.
+template <class Prepared>
+Fq12 millerLoop(G1 const* _p, Prepared const& _prepared, size_t _count)
+{
+	Fq12 f = Fq12::one();
+	size_t idx = 0;
+	for (size_t i = c_ateLoopCount.numBits() - 1; i-- > 0;)
+	{
+		f = f.squared();
+		for (size_t k = 0; k < _count; ++k)
+			f = evaluate(f, _prepared(k).coeffs[idx], _p[k]);
+		++idx;
+		if (c_ateLoopCount.testBit(i))
+		{
+			for (size_t k = 0; k < _count; ++k)
+				f = evaluate(f, _prepared(k).coeffs[idx], _p[k]);
+			++idx;
+		}
+	}
+	for (size_t k = 0; k < _count; ++k)
+		f = evaluate(f, _prepared(k).coeffs[idx], _p[k]);
+	++idx;
+	for (size_t k = 0; k < _count; ++k)
+		f = evaluate(f, _prepared(k).coeffs[idx], _p[k]);
+	return f;
+}
+
+/// Fewest pairs for which the AVX-512 IFMA Miller loop is faster, as it
+/// squares eight accumulators and multiplies them in the end.
+size_t constexpr c_ifmaMinPairs = 4;
+
+bool useIfma(size_t _count)
+{
+	static bool const s_available = ifma::compiled() && detectAvx512Ifma();
+	return _count >= c_ifmaMinPairs && s_available;
+}
+
+/// millerLoop with the pairs spread over the lanes of the IFMA kernel.
+template <class Prepared>
+Fq12 ifmaMillerLoop(G1 const* _p, Prepared const& _prepared, size_t _count)
+{
+	static_assert(sizeof(EllCoeffs) == 24 * sizeof(uint64_t), "The kernel reads lines as 24 limbs.");
+	thread_local vector<uint64_t> s_points;
+	thread_local vector<uint64_t const*> s_lines;
+	s_points.resize(8 * _count);
+	s_lines.resize(_count);
+	for (size_t k = 0; k < _count; ++k)
+	{
+		copy_n(_p[k].x.montgomery().data, 4, s_points.data() + 8 * k);
+		copy_n(_p[k].y.montgomery().data, 4, s_points.data() + 8 * k + 4);
+		s_lines[k] = reinterpret_cast<uint64_t const*>(_prepared(k).coeffs.data());
+	}
+	uint64_t lanes[48 * ifma::c_lanes];
+	ifma::multiMillerLoop(s_points.data(), s_lines.data(), _count, lanes);
+
+	auto element = [](uint64_t const* _limbs) {
+		return Fq::fromMontgomery({{_limbs[0], _limbs[1], _limbs[2], _limbs[3]}});
+	};
+	auto fq6 = [&](uint64_t const* _limbs) {
+		return Fq6(
+			Fq2(element(_limbs), element(_limbs + 4)),
+			Fq2(element(_limbs + 8), element(_limbs + 12)),
+			Fq2(element(_limbs + 16), element(_limbs + 20))
+		);
+	};
+	Fq12 f = Fq12::one();
+	for (size_t lane = 0; lane < ifma::c_lanes; ++lane)
+		f *= Fq12(fq6(lanes + 48 * lane), fq6(lanes + 48 * lane + 24));
+	return f;
+}
+
+/// _f^-z for the BN parameter z = 0x44e992b44a6909f1, with an addition chain
+/// of 62 cyclotomic squarings and 17 multiplications instead of the 27 of
+/// square-and-multiply. xN stands for _f^0xN.
+Fq12 expByNegZ(Fq12 const& _f)
+{
+	auto squarings = [](Fq12 _x, size_t _n) {
+		for (size_t i = 0; i < _n; ++i)
+			_x = _x.cyclotomicSquared();
+		return _x;
+	};
+
+	Fq12 const x2 = _f.cyclotomicSquared();
+	Fq12 const x4 = x2.cyclotomicSquared();
+	Fq12 const x8 = x4.cyclotomicSquared();
+	Fq12 const x11 = _f * x8.cyclotomicSquared();
+	Fq12 const x13 = x2 * x11;
+	Fq12 const x19 = x8 * x11;
+	Fq12 const x27 = x13 * (_f * x13);
+	Fq12 const x29 = x2 * x27;
+
+	Fq12 r = x19 * (x4 * squarings(x11.cyclotomicSquared(), 6));	// 0x89d
+	r = x19 * squarings(r, 7);	// 0x44e99
+	r = x2 * (x29 * squarings(r, 8));	// 0x44e992b
+	r = x11 * squarings(r, 6);	// 0x113a64ad1
+	r = x29 * squarings(r, 8);	// 0x113a64ad129
+	r = x29 * squarings(r, 6);	// 0x44e992b44a69
+	r = x27 * squarings(r, 10);	// 0x113a64ad129a427
+	r = x8 * (x29 * squarings(r, 6));	// 0x44e992b44a6909f1
+	return r.unitaryInverse();
+}
+
+/// f^((p^6 - 1)(p^2 + 1))
+Fq12 finalExponentiationFirstChunk(Fq12 const& _f)
+{
+	Fq12 const a = _f.unitaryInverse() * _f.inverse();
+	return a.frobeniusMap(2) * a;
+}
+
+/// Hard part, following Fuentes-Castaneda, Knapp and Rodriguez-Henriquez,
+/// "Faster hashing to G2", with the same multiplication chain as libff.
+Fq12 finalExponentiationLastChunk(Fq12 const& _f)
+{
+	Fq12 const a = expByNegZ(_f);
+	Fq12 const b = a.cyclotomicSquared();
+	Fq12 const c = b.cyclotomicSquared();
+	Fq12 const d = c * b;
+	Fq12 const e = expByNegZ(d);
+	Fq12 const f = e.cyclotomicSquared();
+	Fq12 const g = expByNegZ(f);
+	Fq12 const h = d.unitaryInverse();
+	Fq12 const i = g.unitaryInverse();
+	Fq12 const j = i * e;
+	Fq12 const k = j * h;
+	Fq12 const l = k * b;
+	Fq12 const m = k * e;
+	Fq12 const n = m * _f;
+	Fq12 const o = l.frobeniusMap(1);
+	Fq12 const p = o * n;
+	Fq12 const q = k.frobeniusMap(2);
+	Fq12 const r = q * p;
+	Fq12 const s = _f.unitaryInverse();
+	Fq12 const t = s * l;
+	Fq12 const u = t.frobeniusMap(3);
+	return u * r;
+}
+
+}
+
+Fq const& G1Params::b()
+{
+	static Fq const s_b(3);
+	return s_b;
+}
+
+Fq2 const& G2Params::b()
+{
+	return constants().twistB;
+}
+
+TowerFrobenius<TowerConfig> const& TowerConfig::frobenius()
+{
+	return constants().frobenius;
+}
+
+G1 const& alt_bn128::g1Generator()
+{
+	static G1 const s_generator = G1::fromAffine(Fq(1), Fq(2));
+	return s_generator;
+}
+
+G2 const& alt_bn128::g2Generator()
+{
+	static G2 const s_generator = G2::fromAffine(
+		Fq2(
+			Fq::reduce({{0x46debd5cd992f6ed, 0x674322d4f75edadd, 0x426a00665e5c4479, 0x1800deef121f1e76}}),
+			Fq::reduce({{0x97e485b7aef312c2, 0xf1aa493335a9e712, 0x7260bfb731fb5d25, 0x198e9393920d483a}})
+		),
+		Fq2(
+			Fq::reduce({{0x4ce6cc0166fa7daa, 0xe3d1e7690c43d37b, 0x4aab71808dcb408f, 0x12c85ea5db8c6deb}}),
+			Fq::reduce({{0x55acdadcd122975b, 0xbc4b313370b38ef3, 0xec9e99ad690c3395, 0x090689d0585ff075}})
+		)
+	);
+	return s_generator;
+}
+
+FixedBaseTable<G1> const& alt_bn128::g1GeneratorTable()
+{
+	static FixedBaseTable<G1> const s_table(g1Generator(), 256, c_fixedBaseWindowBits);
+	return s_table;
+}
+
+FixedBaseTable<G2> const& alt_bn128::g2GeneratorTable()
+{
+	static FixedBaseTable<G2> const s_table(g2Generator(), 256, c_fixedBaseWindowBits);
+	return s_table;
+}
+
+void alt_bn128::mapToG1(Fq const* _u, size_t _count, G1* o_points)
+{
+	Constants const& c = constants();
+	Fq const one = Fq::one();
+	Fq const four = Fq(4);
+	auto curve = [](Fq const& _x) { return _x.squared() * _x + G1Params::b(); };
+
+	// Straight-line map of RFC 9380 section 6.6.1 with the one inversion per
+	// element batched. inv0 maps zero to zero, so zero denominators (a
+	// negligible share of inputs) are replaced by one before inverting and
+	// the result is cleared afterwards.
+	vector<Fq> tv1(_count);
+	vector<Fq> tv2(_count);
+	vector<Fq> tv3(_count);
+	vector<uint8_t> zeroDenominator(_count);
+	for (size_t i = 0; i < _count; ++i)
+	{
+		Fq const t = _u[i].squared() * four;
+		tv2[i] = one + t;
+		tv1[i] = one - t;
+		Fq const d = tv1[i] * tv2[i];
+		zeroDenominator[i] = d.isZero();
+		tv3[i] = Fq::select(zeroDenominator[i], one, d);
+	}
+	batchInvert(tv3);
+
+	for (size_t i = 0; i < _count; ++i)
+	{
+		Fq const inv = Fq::select(zeroDenominator[i], Fq::zero(), tv3[i]);
+		Fq const tv4 = _u[i] * tv1[i] * inv * c.svdwC3;
+		Fq const x1 = c.svdwC2 - tv4;
+		Fq const x2 = c.svdwC2 + tv4;
+		Fq const x3 = (tv2[i].squared() * inv).squared() * c.svdwC4 + one;
+		bool const e1 = curve(x1).isSquare();
+		bool const e2 = curve(x2).isSquare() & !e1;
+		Fq const x = Fq::select(e2, x2, Fq::select(e1, x1, x3));
+		Fq y;
+		curve(x).sqrt(y);
+		o_points[i] = G1::fromAffine(x, Fq::select(_u[i].isOdd() == y.isOdd(), y, -y));
+	}
+}
+
+vector<G1> alt_bn128::hashToG1(vector<bytesConstRef> const& _messages, bytesConstRef _dst)
+{
+	// L = ceil((ceil(log2(p)) + 128) / 8) bytes per field element.
+	size_t constexpr elementSize = 48;
+	vector<Fq> u(2 * _messages.size());
+	for (size_t i = 0; i < _messages.size(); ++i)
+	{
+		bytes const uniform = expandMessageXmd(_messages[i], _dst, 2 * elementSize);
+		for (size_t j = 0; j < 2; ++j)
+		{
+			// OS2IP mod p = hi * 2^256 + lo with 2^256 mod p = R mod p.
+			byte const* const element = uniform.data() + j * elementSize;
+			BigInt<4> hi;
+			BigInt<4> lo;
+			hi.fromBigEndian(element, elementSize - 32);
+			lo.fromBigEndian(element + elementSize - 32, 32);
+			u[2 * i + j] = Fq::reduce(hi) * Fq::reduce(Fq::c_r) + Fq::reduce(lo);
+		}
+	}
+
+	vector<G1> mapped(u.size());
+	mapToG1(u.data(), u.size(), mapped.data());
+	// G1 has cofactor 1, so the sum needs no clearing.
+	vector<G1> points(_messages.size());
+	for (size_t i = 0; i < points.size(); ++i)
+		points[i] = mapped[2 * i].mixedAdd(mapped[2 * i + 1]);
+	return points;
+}
+
+G1 alt_bn128::hashToG1(bytesConstRef _message, bytesConstRef _dst)
+{
+	return hashToG1(vector<bytesConstRef>{_message}, _dst).front();
+}
+
+bool alt_bn128::isInG2Subgroup(G2 const& _q)
+{
+	// [r]Q == 0 iff [z + 1]Q + psi([z]Q) + psi^2([z]Q) == psi^3([2z]Q)
+	// (El Housni, Guillevic and Piellard, "Co-factor clearing and subgroup
+	// membership testing on pairing-friendly curves", section 5.1).
+	G2 const zq = _q.mul(c_z);
+	G2 const psiZq = psi(zq);
+	G2 const psi2Zq = psi(psiZq);
+	return zq + _q + psiZq + psi2Zq == psi(psi2Zq).dbl();
+}
+
+G2 alt_bn128::psi(G2 const& _q)
+{
+	// The Frobenius map commutes with the Jacobian coordinate scaling.
+	Constants const& c = constants();
+	return G2(c.twistMulByQX * _q.x.conjugate(), c.twistMulByQY * _q.y.conjugate(), _q.z.conjugate());
+}
+
+G2 alt_bn128::mulG2(G2 const& _q, BigInt<4> const& _k)
+{
+	if (_q.isZero() || _k.isZero())
+		return G2::zero();
+
+	// The scalar may be up to 2^256 > 5r.
+	BigInt<4> k = _k;
+	while (k >= order())
+		bigint::sub(k, k, order());
+	BigInt<4> k0;
+	BigInt<4> k1;
+	splitScalar(k, k0, k1);
+
+	int8_t naf0[G2::c_maxNafDigits<BigInt<4>>];
+	int8_t naf1[G2::c_maxNafDigits<BigInt<4>>];
+	size_t const len0 = G2::wnaf(k0, naf0);
+	size_t const len1 = G2::wnaf(k1, naf1);
+	G2 table0[8];
+	G2 table1[8];
+	_q.oddMultiples(table0);
+	for (size_t i = 0; i < 8; ++i)
+		table1[i] = psi(table0[i]);
+
+	G2 r;
+	for (size_t i = max(len0, len1); i-- > 0;)
+	{
+		r = r.dbl();
+		if (i < len0)
+			G2::addNafDigit(r, table0, naf0[i]);
+		if (i < len1)
+			G2::addNafDigit(r, table1, naf1[i]);
+	}
+	return r;
+}
+
+G2Prepared alt_bn128::prepareG2(G2 const& _q)
+{
+	G2Prepared result;
+	prepareG2(_q, result);
+	return result;
+}
+
+void alt_bn128::prepareG2(G2 const& _q, G2Prepared& o_prepared)
+{
+	Constants const& c = constants();
+	vector<EllCoeffs>& coeffs = o_prepared.coeffs;
+	coeffs.clear();
+	G2 r = _q;
+	for (size_t i = c_ateLoopCount.numBits() - 1; i-- > 0;)
+	{
+		coeffs.push_back(doublingStep(r));
+		if (c_ateLoopCount.testBit(i))
+			coeffs.push_back(additionStep(_q, r));
+	}
+
+	// Q1 = pi(Q), Q2 = -pi^2(Q)
+	G2 const q1(c.twistMulByQX * _q.x.conjugate(), c.twistMulByQY * _q.y.conjugate(), Fq2::one());
+	G2 const q2(c.twistMulByQX * q1.x.conjugate(), -(c.twistMulByQY * q1.y.conjugate()), Fq2::one());
+	coeffs.push_back(additionStep(q1, r));
+	coeffs.push_back(additionStep(q2, r));
+}
+
+G2Prepared alt_bn128::prepareG2OrEmpty(G2 const& _q)
+{
+	return _q.isZero() ? G2Prepared{} : prepareG2(_q.toAffine());
+}
+
+Fq12 alt_bn128::multiMillerLoop(G1 const* _p, G2Prepared const* const* _q, size_t _count)
+{
+	auto prepared = [&](size_t _k) -> G2Prepared const& { return *_q[_k]; };
+	if (useIfma(_count))
+		return ifmaMillerLoop(_p, prepared, _count);
+	return millerLoop(_p, prepared, _count);
+}
+
+Fq12 alt_bn128::multiMillerLoop(G1 const* _p, G2Prepared const* _q, size_t _count)
+{
+	auto prepared = [&](size_t _k) -> G2Prepared const& { return _q[_k]; };
+	if (useIfma(_count))
+		return ifmaMillerLoop(_p, prepared, _count);
+	return millerLoop(_p, prepared, _count);
+}
+
+Fq12 alt_bn128::multiMillerLoopSkippingZero(G1* io_p, G2Prepared const** io_q, size_t _count)
+{
+	return multiMillerLoop(io_p, io_q, compactPairs(io_p, io_q, _count));
+}
+
+Fq12 alt_bn128::finalExponentiation(Fq12 const& _f)
+{
+	return finalExponentiationLastChunk(finalExponentiationFirstChunk(_f));
+}
@@ -0,0 +1,164 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2014-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+/** @file Bn254.h
+ * Native arithmetic of the alt_bn128 (BN254) pairing-friendly curve.
+ *
+ * E: y^2 = x^3 + 3 over Fq, the D-type twist E': y^2 = x^3 + 3 / xi over Fq2
+ * with xi = 9 + u, and the optimal ate pairing e: G1 x G2 -> Fq12.
+ */
+
+#pragma once
+
+#include "EllipticCurve.h"
+#include "Montgomery.h"
+#include "Tower.h"
+
+#include <libdevcore/Common.h>
+
+#include <vector>
+
+namespace dev
+{
+namespace crypto
+{
+namespace alt_bn128
+{
+
+struct FqParams
+{
+	static constexpr size_t limbs = 4;
+	static constexpr BigInt<4> modulus()
+	{
+		return {{0x3c208c16d87cfd47, 0x97816a916871ca8d, 0xb85045b68181585d, 0x30644e72e131a029}};
+	}
+};
+
+struct FrParams
+{
+	static constexpr size_t limbs = 4;
+	static constexpr BigInt<4> modulus()
+	{
+		return {{0x43e1f593f0000001, 0x2833e84879b97091, 0xb85045b68181585d, 0x30644e72e131a029}};
+	}
+};
+
+/// Base field.
+using Fq = MontgomeryField<FqParams>;
+/// Scalar field, i.e. integers modulo the group order r.
+using Fr = MontgomeryField<FrParams>;
+using Fq2 = Fp2T<Fq>;
+
+struct TowerConfig
+{
+	using Fp = Fq;
+	using Fp2 = Fq2;
+
+	/// Multiplication by xi = 9 + u.
+	static Fq2 mulByXi(Fq2 const& _a)
+	{
+		Fq const a9 = _a.c0.dbl().dbl().dbl() + _a.c0;
+		Fq const b9 = _a.c1.dbl().dbl().dbl() + _a.c1;
+		return Fq2(a9 - _a.c1, _a.c0 + b9);
+	}
+
+	static TowerFrobenius<TowerConfig> const& frobenius();
+};
+
+using Fq6 = Fp6T<TowerConfig>;
+using Fq12 = Fp12T<TowerConfig>;
+
+struct G1Params
+{
+	static Fq const& b();
+};
+
+struct G2Params
+{
+	static Fq2 const& b();
+};
+
+using G1 = JacobianPoint<Fq, G1Params>;
+using G2 = JacobianPoint<Fq2, G2Params>;
+
+/// Group order r.
+inline Fr::Int const& order() { return Fr::c_modulus; }
+
+/// The generators (1, 2) of G1 and the one of G2 fixed by EIP-197.
+G1 const& g1Generator();
+G2 const& g2Generator();
+
+/// Window width of fixed-base tables of the generators and other long-lived
+/// points. 43 windows of 63 points each take about 250 kB for G1 and twice
+/// that for G2.
+unsigned constexpr c_fixedBaseWindowBits = 6;
+
+/// Fixed-base tables of the generators covering 256 bit scalars, built on
+/// first use and shared by all threads.
+FixedBaseTable<G1> const& g1GeneratorTable();
+FixedBaseTable<G2> const& g2GeneratorTable();
+
+/// Shallue-van de Woestijne map of RFC 9380 from field elements to affine
+/// points of G1, with the inversions of all @a _count elements batched. The
+/// field arithmetic does not branch on the inputs.
+void mapToG1(Fq const* _u, size_t _count, G1* o_points);
+
+/// Hash-to-curve of RFC 9380 with the suite BN254G1_XMD:SHA-256_SVDW_RO_:
+/// expand_message_xmd with SHA-256 yields two field elements whose images
+/// under mapToG1 are added. @a _dst separates the domains of applications.
+G1 hashToG1(bytesConstRef _message, bytesConstRef _dst);
+
+/// Hashes many messages under one tag, sharing the inversions of the map.
+std::vector<G1> hashToG1(std::vector<bytesConstRef> const& _messages, bytesConstRef _dst);
+
+/// @returns true if @a _q lies in the order r subgroup of the twist.
+bool isInG2Subgroup(G2 const& _q);
+
+/// The untwist-Frobenius-twist endomorphism psi, which acts on G2 as
+/// multiplication by p mod r = 6z^2.
+G2 psi(G2 const& _q);
+
+/// Scalar multiplication of a point of G2 using psi: the scalar is split into
+/// k0 + k1 * 6z^2 with halves of about 127 bits, which halves the doublings.
+/// The result is wrong for points outside G2.
+G2 mulG2(G2 const& _q, BigInt<4> const& _k);
+
+/// Coefficients of one line function of the Miller loop, evaluated at P as
+/// ell0 + ellVW * yP w^3 + ellVV * xP w^4.
+struct EllCoeffs
+{
+	Fq2 ell0;
+	Fq2 ellVW;
+	Fq2 ellVV;
+};
+
+/// The line functions of the Miller loop for a fixed G2 point.
+struct G2Prepared
+{
+	std::vector<EllCoeffs> coeffs;
+};
+
+/// Precomputes the Miller loop lines of a non-zero G2 point in affine form.
+G2Prepared prepareG2(G2 const& _q);
+/// Same, but reuses the storage of @a o_prepared, so it does not allocate if
+/// @a o_prepared held the lines of a point before.
+void prepareG2(G2 const& _q, G2Prepared& o_prepared);
+/// Lines of @a _q, or no lines for the zero point, whose lines are never
+/// evaluated.
+G2Prepared prepareG2OrEmpty(G2 const& _q);
+
+/// Product of the Miller loops of @a _count pairs (_p[i], _q[i]) sharing the
+/// squarings of the accumulator. The G1 points must be non-zero and affine.
+Fq12 multiMillerLoop(G1 const* _p, G2Prepared const* const* _q, size_t _count);
+Fq12 multiMillerLoop(G1 const* _p, G2Prepared const* _q, size_t _count);
+/// Same for G1 points in any form and G2 points prepared by
+/// prepareG2OrEmpty(): converts the G1 points to affine form and skips the
+/// pairs with a zero point, which contribute a factor of one. Overwrites
+/// @a io_p and @a io_q.
+Fq12 multiMillerLoopSkippingZero(G1* io_p, G2Prepared const** io_q, size_t _count);
+
+Fq12 finalExponentiation(Fq12 const& _f);
+
+}
+}
+}
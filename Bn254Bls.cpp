@@ -0,0 +1,156 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2014-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+
+#include <libdevcrypto/Bn254Bls.h>
+#include <libdevcrypto/Hash.h>
+
+#include <cstring>
+
+using namespace std;
+using namespace dev;
+using namespace dev::crypto;
+using namespace dev::crypto::alt_bn128;
+
+namespace
+{
+
+/// Ciphersuite tag of the basic scheme, named as in the IETF BLS draft.
+char const c_hashToG1Dst[] = "BLS_SIG_BN254G1_XMD:SHA-256_SVDW_RO_NUL_";
+
+G1 hashMessage(bytesConstRef _message)
+{
+	return hashToG1(_message, bytesConstRef(reinterpret_cast<byte const*>(c_hashToG1Dst), sizeof(c_hashToG1Dst) - 1));
+}
+
+h256 hmacSha256(bytesConstRef _key, bytesConstRef _data)
+{
+	size_t constexpr blockSize = 64;
+	bytes key(blockSize, 0);
+	if (_key.size() > blockSize)
+	{
+		h256 const hashedKey = sha256(_key);
+		memcpy(key.data(), hashedKey.data(), hashedKey.size);
+	}
+	else
+		memcpy(key.data(), _key.data(), _key.size());
+
+	bytes inner(blockSize);
+	bytes outer(blockSize);
+	for (size_t i = 0; i < blockSize; ++i)
+	{
+		inner[i] = key[i] ^ 0x36;
+		outer[i] = key[i] ^ 0x5c;
+	}
+	inner.insert(inner.end(), _data.begin(), _data.end());
+	h256 const innerHash = sha256(bytesConstRef(&inner));
+	outer.insert(outer.end(), innerHash.begin(), innerHash.end());
+	return sha256(bytesConstRef(&outer));
+}
+
+/// HKDF-Expand of RFC 5869 with SHA-256.
+bytes hkdfExpand(h256 const& _prk, bytesConstRef _info, size_t _length)
+{
+	bytes okm;
+	bytes block;
+	for (uint8_t i = 1; okm.size() < _length; ++i)
+	{
+		block.insert(block.end(), _info.begin(), _info.end());
+		block.push_back(i);
+		h256 const t = hmacSha256(_prk.ref(), bytesConstRef(&block));
+		block.assign(t.begin(), t.end());
+		okm.insert(okm.end(), t.begin(), t.end());
+	}
+	okm.resize(_length);
+	return okm;
+}
+
+/// Sum of points given in any form, via batchAffineSum.
+template <class Point>
+Point sumPoints(vector<Point> _points)
+{
+	Point::batchToAffine(_points);
+	return batchAffineSum(move(_points));
+}
+
+/// e(_signature, g2) == e(_hash, _publicKey), checked as
+/// e(_signature, -g2) * e(_hash, _publicKey) == 1.
+bool verifyHashed(G2 const& _publicKey, G1 const& _hash, G1 const& _signature)
+{
+	if (_publicKey.isZero() || _signature.isZero() || !_signature.isOnCurve())
+		return false;
+
+	static G2Prepared const s_negG2 = prepareG2(-g2Generator());
+	G2Prepared const publicKey = prepareG2(_publicKey.toAffine());
+	G1 const p[] = {_signature.toAffine(), _hash.toAffine()};
+	G2Prepared const* const q[] = {&s_negG2, &publicKey};
+	return finalExponentiation(multiMillerLoop(p, q, 2)).isOne();
+}
+
+}
+
+bool alt_bn128::blsKeyGen(bytesConstRef _ikm, Fr& o_secretKey)
+{
+	// L = ceil(3 * ceil(log2(r)) / 16) bytes leave a negligible bias mod r.
+	size_t constexpr okmSize = 48;
+	if (_ikm.size() < 32)
+		return false;
+
+	string const saltText = "BLS-SIG-KEYGEN-SALT-";
+	h256 salt = sha256(bytesConstRef(reinterpret_cast<byte const*>(saltText.data()), saltText.size()));
+	bytes ikm(_ikm.begin(), _ikm.end());
+	ikm.push_back(0);
+	// key_info is empty, followed by I2OSP(L, 2).
+	bytes const info{0, okmSize};
+	while (true)
+	{
+		h256 const prk = hmacSha256(bytesConstRef(salt.data(), salt.size), bytesConstRef(&ikm));
+		bytes const okm = hkdfExpand(prk, bytesConstRef(&info), okmSize);
+
+		// OS2IP(okm) mod r = hi * 2^256 + lo with 2^256 mod r = R mod r.
+		BigInt<4> hi;
+		BigInt<4> lo;
+		hi.fromBigEndian(okm.data(), okmSize - 32);
+		lo.fromBigEndian(okm.data() + okmSize - 32, 32);
+		o_secretKey = Fr::reduce(hi) * Fr::reduce(Fr::c_r) + Fr::reduce(lo);
+		if (!o_secretKey.isZero())
+			return true;
+		salt = sha256(bytesConstRef(salt.data(), salt.size));
+	}
+}
+
+G2 alt_bn128::blsPublicKey(Fr const& _secretKey)
+{
+	return g2GeneratorTable().mul(_secretKey.toCanonical());
+}
+
+bool alt_bn128::blsKeyValidate(G2 const& _publicKey)
+{
+	return !_publicKey.isZero() && _publicKey.isOnCurve() && isInG2Subgroup(_publicKey);
+}
+
+G1 alt_bn128::blsSign(Fr const& _secretKey, bytesConstRef _message)
+{
+	return hashMessage(_message).mul(_secretKey.toCanonical());
+}
+
+bool alt_bn128::blsVerify(G2 const& _publicKey, bytesConstRef _message, G1 const& _signature)
+{
+	return verifyHashed(_publicKey, hashMessage(_message), _signature);
+}
+
+G1 alt_bn128::blsAggregate(vector<G1> const& _signatures)
+{
+	return sumPoints(_signatures);
+}
+
+bool alt_bn128::blsFastAggregateVerify(
+	vector<G2> const& _publicKeys,
+	bytesConstRef _message,
+	G1 const& _signature
+)
+{
+	if (_publicKeys.empty())
+		return false;
+	return verifyHashed(sumPoints(_publicKeys), hashMessage(_message), _signature);
+}
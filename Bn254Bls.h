@@ -0,0 +1,61 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2014-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+/** @file Bn254Bls.h
+ * BLS signatures over alt_bn128 with signatures in G1 and public keys in G2.
+ *
+ * A signature on m is sk * H(m) and verifies if e(sig, g2) == e(H(m), pk),
+ * where H is hashToG1 under the tag BLS_SIG_BN254G1_XMD:SHA-256_SVDW_RO_NUL_.
+ */
+
+#pragma once
+
+#include "Bn254.h"
+
+#include <libdevcore/Common.h>
+
+#include <vector>
+
+namespace dev
+{
+namespace crypto
+{
+namespace alt_bn128
+{
+
+/// Derives a secret key from at least 32 bytes of keying material with
+/// HKDF-SHA256 as in the KeyGen procedure of the IETF BLS signature draft.
+/// @returns false if @a _ikm is too short.
+bool blsKeyGen(bytesConstRef _ikm, Fr& o_secretKey);
+
+G2 blsPublicKey(Fr const& _secretKey);
+
+/// @returns false if @a _publicKey is zero or not in G2. Every key has to pass
+/// this once, e.g. on registration, before it is used in any verification.
+bool blsKeyValidate(G2 const& _publicKey);
+
+G1 blsSign(Fr const& _secretKey, bytesConstRef _message);
+
+/// Verifies a signature under a validated public key.
+bool blsVerify(G2 const& _publicKey, bytesConstRef _message, G1 const& _signature);
+
+/// Sum of the signatures, which verifies against the sum of the public keys
+/// for a common message.
+G1 blsAggregate(std::vector<G1> const& _signatures);
+
+/// Verifies an aggregate signature of many signers on the same message with a
+/// single 2-pair pairing check. The public keys are summed with batched affine
+/// additions, so the cost barely depends on their number.
+///
+/// As the signers are not distinguished, every key must come with a proof of
+/// possession of its secret key (checked outside this function) to rule out
+/// rogue key attacks, and must have passed blsKeyValidate.
+bool blsFastAggregateVerify(
+	std::vector<G2> const& _publicKeys,
+	bytesConstRef _message,
+	G1 const& _signature
+);
+
+}
+}
+}
@@ -0,0 +1,368 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2014-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+
+#include "Bn254Ifma.h"
+
+#if defined(__AVX512F__) && defined(__AVX512IFMA__)
+
+#include "Bn254.h"
+
+#include <immintrin.h>
+
+using namespace std;
+using namespace dev;
+using namespace dev::crypto;
+using namespace dev::crypto::alt_bn128;
+
+// Everything below has internal linkage: the tower templates are instantiated
+// with types of the unnamed namespace only, so no inline function of another
+// translation unit is ever emitted here with AVX-512 instructions.
+namespace
+{
+
+uint64_t constexpr c_mask = (uint64_t(1) << 52) - 1;
+
+/// A number below 2^260 as five 52-bit limbs, least significant first.
+struct Limbs
+{
+	uint64_t v[5];
+};
+
+constexpr Limbs toLimbs(BigInt<4> const& _a)
+{
+	return {{
+		_a.data[0] & c_mask,
+		((_a.data[0] >> 52) | (_a.data[1] << 12)) & c_mask,
+		((_a.data[1] >> 40) | (_a.data[2] << 24)) & c_mask,
+		((_a.data[2] >> 28) | (_a.data[3] << 36)) & c_mask,
+		_a.data[3] >> 16
+	}};
+}
+
+BigInt<4> constexpr c_modulus = FqParams::modulus();
+Limbs constexpr c_p = toLimbs(c_modulus);
+/// -p^-1 mod 2^52.
+uint64_t constexpr c_negInverse = bigint::negInverse64(c_modulus.data[0]) & c_mask;
+/// Montgomery form of one with R = 2^260.
+Limbs constexpr c_one = toLimbs(bigint::powerOfTwoMod(260, c_modulus));
+/// Montgomery multiplication by 2^264 takes the Montgomery form of Fq with
+/// R = 2^256 to the one of the lanes, by 2^256 back.
+Limbs constexpr c_toLanes = toLimbs(bigint::powerOfTwoMod(264, c_modulus));
+Limbs constexpr c_fromLanes = toLimbs(bigint::powerOfTwoMod(256, c_modulus));
+
+/// The 6z + 2 of the Miller loop as in Bn254.cpp, 65 bits.
+uint64_t constexpr c_ateLoopCount[2] = {0x9d797039be763ba8, 0x1};
+size_t constexpr c_ateLoopBits = 65;
+
+bool ateLoopBit(size_t _i)
+{
+	return (c_ateLoopCount[_i / 64] >> (_i % 64)) & 1;
+}
+
+/// Limbs of the elements of one lane vector as stored in memory.
+struct RawFq8
+{
+	uint64_t limbs[5][ifma::c_lanes];
+};
+
+/// Eight elements of Fq, one per lane, in Montgomery form with R = 2^260 and
+/// fully reduced. Implements the part of the MontgomeryField interface that
+/// the tower arithmetic of the Miller loop needs.
+class Fq8
+{
+public:
+	Fq8() = default;
+
+	static Fq8 broadcast(Limbs const& _a)
+	{
+		Fq8 r;
+		DEV_UNROLL
+		for (size_t j = 0; j < 5; ++j)
+			r.m_l[j] = _mm512_set1_epi64(int64_t(_a.v[j]));
+		return r;
+	}
+
+	static Fq8 zero() { return broadcast(Limbs{}); }
+	static Fq8 one() { return broadcast(c_one); }
+
+	/// Loads the element at _elements[lane] + _offset, given in 4 limbs in the
+	/// Montgomery form of Fq, into every lane whose pointer is not null and
+	/// zero into the others.
+	static Fq8 load(uint64_t const* const* _elements, size_t _offset)
+	{
+		alignas(64) uint64_t words[4][ifma::c_lanes] = {};
+		for (size_t lane = 0; lane < ifma::c_lanes; ++lane)
+			if (_elements[lane])
+				for (size_t w = 0; w < 4; ++w)
+					words[w][lane] = _elements[lane][_offset + w];
+		__m512i const w0 = _mm512_load_si512(words[0]);
+		__m512i const w1 = _mm512_load_si512(words[1]);
+		__m512i const w2 = _mm512_load_si512(words[2]);
+		__m512i const w3 = _mm512_load_si512(words[3]);
+		__m512i const mask = _mm512_set1_epi64(int64_t(c_mask));
+		Fq8 r;
+		r.m_l[0] = _mm512_and_si512(w0, mask);
+		r.m_l[1] = _mm512_and_si512(_mm512_or_si512(_mm512_srli_epi64(w0, 52), _mm512_slli_epi64(w1, 12)), mask);
+		r.m_l[2] = _mm512_and_si512(_mm512_or_si512(_mm512_srli_epi64(w1, 40), _mm512_slli_epi64(w2, 24)), mask);
+		r.m_l[3] = _mm512_and_si512(_mm512_or_si512(_mm512_srli_epi64(w2, 28), _mm512_slli_epi64(w3, 36)), mask);
+		r.m_l[4] = _mm512_srli_epi64(w3, 16);
+		return r * broadcast(c_toLanes);
+	}
+
+	/// Writes the element of every lane in 4 limbs of the Montgomery form of
+	/// Fq to o_elements + lane * _stride.
+	void store(uint64_t* o_elements, size_t _stride) const
+	{
+		Fq8 const a = *this * broadcast(c_fromLanes);
+		__m512i const l[5] = {a.m_l[0], a.m_l[1], a.m_l[2], a.m_l[3], a.m_l[4]};
+		alignas(64) uint64_t words[4][ifma::c_lanes];
+		_mm512_store_si512(words[0], _mm512_or_si512(l[0], _mm512_slli_epi64(l[1], 52)));
+		_mm512_store_si512(words[1], _mm512_or_si512(_mm512_srli_epi64(l[1], 12), _mm512_slli_epi64(l[2], 40)));
+		_mm512_store_si512(words[2], _mm512_or_si512(_mm512_srli_epi64(l[2], 24), _mm512_slli_epi64(l[3], 28)));
+		_mm512_store_si512(words[3], _mm512_or_si512(_mm512_srli_epi64(l[3], 36), _mm512_slli_epi64(l[4], 16)));
+		for (size_t lane = 0; lane < ifma::c_lanes; ++lane)
+			for (size_t w = 0; w < 4; ++w)
+				o_elements[lane * _stride + w] = words[w][lane];
+	}
+
+	static Fq8 loadRaw(RawFq8 const& _raw)
+	{
+		Fq8 r;
+		DEV_UNROLL
+		for (size_t j = 0; j < 5; ++j)
+			r.m_l[j] = _mm512_loadu_si512(_raw.limbs[j]);
+		return r;
+	}
+
+	void storeRaw(RawFq8& o_raw) const
+	{
+		DEV_UNROLL
+		for (size_t j = 0; j < 5; ++j)
+			_mm512_storeu_si512(o_raw.limbs[j], m_l[j]);
+	}
+
+	/// @returns _ifTrue in the lanes set in @a _condition, _ifFalse elsewhere.
+	static Fq8 select(__mmask8 _condition, Fq8 const& _ifTrue, Fq8 const& _ifFalse)
+	{
+		Fq8 r;
+		DEV_UNROLL
+		for (size_t j = 0; j < 5; ++j)
+			r.m_l[j] = _mm512_mask_blend_epi64(_condition, _ifFalse.m_l[j], _ifTrue.m_l[j]);
+		return r;
+	}
+
+	Fq8 operator+(Fq8 const& _b) const
+	{
+		__m512i t[5];
+		DEV_UNROLL
+		for (size_t j = 0; j < 5; ++j)
+			t[j] = _mm512_add_epi64(m_l[j], _b.m_l[j]);
+		carry(t);
+		return reduceOnce(t);
+	}
+
+	Fq8 operator-(Fq8 const& _b) const
+	{
+		__m512i t[5];
+		DEV_UNROLL
+		for (size_t j = 0; j < 5; ++j)
+			t[j] = _mm512_sub_epi64(m_l[j], _b.m_l[j]);
+		carry(t);
+		// The top limb is negative iff a < b; add p back in those lanes.
+		__mmask8 const negative = _mm512_cmplt_epi64_mask(t[4], _mm512_setzero_si512());
+		DEV_UNROLL
+		for (size_t j = 0; j < 5; ++j)
+			t[j] = _mm512_mask_add_epi64(t[j], negative, t[j], limbOfP(j));
+		carry(t);
+		Fq8 r;
+		DEV_UNROLL
+		for (size_t j = 0; j < 5; ++j)
+			r.m_l[j] = t[j];
+		return r;
+	}
+
+	Fq8 operator-() const { return zero() - *this; }
+
+	/// Montgomery multiplication, operand scanning with the reduction of each
+	/// row interleaved. The limbs of the accumulator stay unnormalised, which
+	/// the 64-bit lanes absorb with room to spare.
+	Fq8 operator*(Fq8 const& _b) const
+	{
+		__m512i const zero = _mm512_setzero_si512();
+		__m512i const negInverse = _mm512_set1_epi64(int64_t(c_negInverse));
+		__m512i t[6] = {zero, zero, zero, zero, zero, zero};
+		DEV_UNROLL
+		for (size_t i = 0; i < 5; ++i)
+		{
+			DEV_UNROLL
+			for (size_t j = 0; j < 5; ++j)
+			{
+				t[j] = _mm512_madd52lo_epu64(t[j], m_l[i], _b.m_l[j]);
+				t[j + 1] = _mm512_madd52hi_epu64(t[j + 1], m_l[i], _b.m_l[j]);
+			}
+			__m512i const m = _mm512_madd52lo_epu64(zero, t[0], negInverse);
+			DEV_UNROLL
+			for (size_t j = 0; j < 5; ++j)
+			{
+				t[j] = _mm512_madd52lo_epu64(t[j], m, limbOfP(j));
+				t[j + 1] = _mm512_madd52hi_epu64(t[j + 1], m, limbOfP(j));
+			}
+			// The low 52 bits of t[0] are zero now.
+			t[1] = _mm512_add_epi64(t[1], _mm512_srli_epi64(t[0], 52));
+			DEV_UNROLL
+			for (size_t j = 0; j < 5; ++j)
+				t[j] = t[j + 1];
+			t[5] = zero;
+		}
+		carry(t);
+		return reduceOnce(t);
+	}
+
+	Fq8& operator+=(Fq8 const& _b) { return *this = *this + _b; }
+	Fq8& operator-=(Fq8 const& _b) { return *this = *this - _b; }
+	Fq8& operator*=(Fq8 const& _b) { return *this = *this * _b; }
+
+	Fq8 dbl() const { return *this + *this; }
+	Fq8 squared() const { return *this * *this; }
+
+private:
+	static __m512i limbOfP(size_t _j) { return _mm512_set1_epi64(int64_t(c_p.v[_j])); }
+
+	/// Moves the bits above 52 of every limb into the next one, with sign.
+	static void carry(__m512i* io_t)
+	{
+		__m512i const mask = _mm512_set1_epi64(int64_t(c_mask));
+		DEV_UNROLL
+		for (size_t j = 0; j < 4; ++j)
+		{
+			io_t[j + 1] = _mm512_add_epi64(io_t[j + 1], _mm512_srai_epi64(io_t[j], 52));
+			io_t[j] = _mm512_and_si512(io_t[j], mask);
+		}
+	}
+
+	/// @returns the normalised value @a _t below 2p reduced below p.
+	static Fq8 reduceOnce(__m512i const* _t)
+	{
+		__m512i d[5];
+		DEV_UNROLL
+		for (size_t j = 0; j < 5; ++j)
+			d[j] = _mm512_sub_epi64(_t[j], limbOfP(j));
+		carry(d);
+		__mmask8 const below = _mm512_cmplt_epi64_mask(d[4], _mm512_setzero_si512());
+		Fq8 r;
+		DEV_UNROLL
+		for (size_t j = 0; j < 5; ++j)
+			r.m_l[j] = _mm512_mask_blend_epi64(below, d[j], _t[j]);
+		return r;
+	}
+
+	__m512i m_l[5];
+};
+
+struct LaneTowerConfig
+{
+	using Fp = Fq8;
+	using Fp2 = Fp2T<Fq8>;
+
+	/// Multiplication by xi = 9 + u, as in TowerConfig.
+	static Fp2 mulByXi(Fp2 const& _a)
+	{
+		Fq8 const a9 = _a.c0.dbl().dbl().dbl() + _a.c0;
+		Fq8 const b9 = _a.c1.dbl().dbl().dbl() + _a.c1;
+		return Fp2(a9 - _a.c1, _a.c0 + b9);
+	}
+};
+
+using Fq2x8 = Fp2T<Fq8>;
+using Fq12x8 = Fp12T<LaneTowerConfig>;
+
+/// Line coefficients are 3 elements of Fq2, i.e. 24 limbs.
+size_t constexpr c_lineLimbs = 24;
+
+Fq2x8 loadFq2(uint64_t const* const* _elements, size_t _offset)
+{
+	return Fq2x8(Fq8::load(_elements, _offset), Fq8::load(_elements, _offset + 4));
+}
+
+}
+
+bool alt_bn128::ifma::compiled()
+{
+	return true;
+}
+
+void alt_bn128::ifma::multiMillerLoop(uint64_t const* _p, uint64_t const* const* _lines, size_t _count, uint64_t* o_f)
+{
+	// Pair k runs in lane k % 8 of group k / 8. Lanes without a pair in a
+	// group get the line 1, which leaves their product unchanged.
+	size_t const groups = (_count + c_lanes - 1) / c_lanes;
+	thread_local vector<RawFq8> s_points;
+	s_points.resize(2 * groups);
+	for (size_t g = 0; g < groups; ++g)
+	{
+		uint64_t const* points[c_lanes];
+		for (size_t lane = 0; lane < c_lanes; ++lane)
+		{
+			size_t const k = g * c_lanes + lane;
+			points[lane] = k < _count ? _p + 8 * k : nullptr;
+		}
+		Fq8::load(points, 0).storeRaw(s_points[2 * g]);
+		Fq8::load(points, 4).storeRaw(s_points[2 * g + 1]);
+	}
+
+	Fq12x8 f = Fq12x8::one();
+	auto addLines = [&](size_t _idx) {
+		for (size_t g = 0; g < groups; ++g)
+		{
+			uint64_t const* lines[c_lanes];
+			__mmask8 present = 0;
+			for (size_t lane = 0; lane < c_lanes; ++lane)
+			{
+				size_t const k = g * c_lanes + lane;
+				lines[lane] = k < _count ? _lines[k] + _idx * c_lineLimbs : nullptr;
+				if (k < _count)
+					present |= __mmask8(1u << lane);
+			}
+			Fq2x8 ell0 = loadFq2(lines, 0);
+			ell0.c0 = Fq8::select(present, ell0.c0, Fq8::one());
+			Fq2x8 const ellVW = loadFq2(lines, 8);
+			Fq2x8 const ellVV = loadFq2(lines, 16);
+			Fq8 const x = Fq8::loadRaw(s_points[2 * g]);
+			Fq8 const y = Fq8::loadRaw(s_points[2 * g + 1]);
+			f = f.mulBy024(ell0, ellVW * y, ellVV * x);
+		}
+	};
+
+	size_t idx = 0;
+	for (size_t i = c_ateLoopBits - 1; i-- > 0;)
+	{
+		f = f.squared();
+		addLines(idx++);
+		if (ateLoopBit(i))
+			addLines(idx++);
+	}
+	addLines(idx++);
+	addLines(idx++);
+
+	size_t constexpr stride = 48;
+	Fq2x8 const* const parts[6] = {&f.c0.c0, &f.c0.c1, &f.c0.c2, &f.c1.c0, &f.c1.c1, &f.c1.c2};
+	for (size_t i = 0; i < 6; ++i)
+	{
+		parts[i]->c0.store(o_f + 8 * i, stride);
+		parts[i]->c1.store(o_f + 8 * i + 4, stride);
+	}
+}
+
+#else
+
+bool dev::crypto::alt_bn128::ifma::compiled()
+{
+	return false;
+}
+
+void dev::crypto::alt_bn128::ifma::multiMillerLoop(uint64_t const*, uint64_t const* const*, size_t, uint64_t*)
+{
+}
+
+#endif
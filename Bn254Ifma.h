@@ -0,0 +1,48 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2014-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+/** @file Bn254Ifma.h
+ * alt_bn128 multi-Miller loop with the base field arithmetic of eight pairs at
+ * a time in the 64-bit lanes of AVX-512 registers, using the 52-bit
+ * multiply-add instructions of AVX-512 IFMA.
+ *
+ * Bn254Ifma.cpp is the only translation unit compiled for AVX-512. It shares
+ * no inline code with the rest of the library and exchanges plain 64-bit
+ * limbs, so nothing compiled for AVX-512 can run on other CPUs. Callers check
+ * compiled() and the CPU features first.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace dev
+{
+namespace crypto
+{
+namespace alt_bn128
+{
+namespace ifma
+{
+
+/// Number of lanes, i.e. of pairs processed together.
+size_t constexpr c_lanes = 8;
+
+/// @returns true if the kernels were compiled in, i.e. the build targets
+/// x86-64 with a compiler supporting AVX-512 IFMA.
+bool compiled();
+
+/// Multi-Miller loop of @a _count pairs with the pairs spread over the lanes.
+/// @a _p holds the affine G1 point of every pair as x | y, and @a _lines[k]
+/// the line coefficients of the prepared G2 point of pair k, laid out as in
+/// G2Prepared. All elements are in the Montgomery form of Fq, 4 limbs each.
+/// Writes the Miller loop product of the pairs of every lane to @a o_f, 48
+/// limbs per lane in the order c0.c0.c0, c0.c0.c1, c0.c1.c0, ..., c1.c2.c1,
+/// which multiply to the product of all pairs.
+void multiMillerLoop(uint64_t const* _p, uint64_t const* const* _lines, size_t _count, uint64_t* o_f);
+
+}
+}
+}
+}
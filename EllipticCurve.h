@@ -0,0 +1,439 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2014-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+/** @file EllipticCurve.h
+ * Points of short Weierstrass curves y^2 = x^3 + b in Jacobian coordinates.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace dev
+{
+namespace crypto
+{
+
+/// Replaces every element of @a io_elements with its inverse using a single
+/// field inversion (Montgomery's trick). All elements must be non-zero.
+template <class Field>
+void batchInvert(Field* io_elements, size_t _count)
+{
+	if (!_count)
+		return;
+	std::vector<Field> prefix(_count);
+	Field acc = Field::one();
+	for (size_t i = 0; i < _count; ++i)
+	{
+		prefix[i] = acc;
+		acc *= io_elements[i];
+	}
+	acc = acc.inverse();
+	for (size_t i = _count; i-- > 0;)
+	{
+		Field const inv = acc * prefix[i];
+		acc *= io_elements[i];
+		io_elements[i] = inv;
+	}
+}
+
+template <class Field>
+void batchInvert(std::vector<Field>& io_elements)
+{
+	batchInvert(io_elements.data(), io_elements.size());
+}
+
+/// Point (X / Z^2, Y / Z^3) of the curve y^2 = x^3 + Params::b().
+/// The point at infinity has Z == 0.
+template <class Field, class Params>
+class JacobianPoint
+{
+public:
+	using FieldType = Field;
+
+	JacobianPoint(): x(Field::one()), y(Field::one()), z(Field::zero()) {}
+	JacobianPoint(Field const& _x, Field const& _y, Field const& _z): x(_x), y(_y), z(_z) {}
+
+	static JacobianPoint zero() { return JacobianPoint(); }
+	static JacobianPoint fromAffine(Field const& _x, Field const& _y) { return JacobianPoint(_x, _y, Field::one()); }
+
+	bool isZero() const { return z.isZero(); }
+
+	/// @returns true if the point satisfies the curve equation.
+	bool isOnCurve() const
+	{
+		if (isZero())
+			return true;
+		Field const z2 = z.squared();
+		Field const z6 = z2.squared() * z2;
+		return y.squared() == x.squared() * x + Params::b() * z6;
+	}
+
+	bool operator==(JacobianPoint const& _b) const
+	{
+		if (isZero() || _b.isZero())
+			return isZero() == _b.isZero();
+		Field const z1z1 = z.squared();
+		Field const z2z2 = _b.z.squared();
+		return
+			x * z2z2 == _b.x * z1z1 &&
+			y * z2z2 * _b.z == _b.y * z1z1 * z;
+	}
+	bool operator!=(JacobianPoint const& _b) const { return !(*this == _b); }
+
+	JacobianPoint operator-() const { return JacobianPoint(x, -y, z); }
+
+	/// dbl-2009-l
+	JacobianPoint dbl() const
+	{
+		if (isZero())
+			return *this;
+		Field const a = x.squared();
+		Field const b = y.squared();
+		Field const c = b.squared();
+		Field const d = ((x + b).squared() - a - c).dbl();
+		Field const e = a.dbl() + a;
+		Field const f = e.squared();
+		Field const x3 = f - d.dbl();
+		Field const y3 = e * (d - x3) - c.dbl().dbl().dbl();
+		Field const z3 = (y * z).dbl();
+		return JacobianPoint(x3, y3, z3);
+	}
+
+	/// add-2007-bl
+	JacobianPoint operator+(JacobianPoint const& _b) const
+	{
+		if (isZero())
+			return _b;
+		if (_b.isZero())
+			return *this;
+		Field const z1z1 = z.squared();
+		Field const z2z2 = _b.z.squared();
+		Field const u1 = x * z2z2;
+		Field const u2 = _b.x * z1z1;
+		Field const s1 = y * _b.z * z2z2;
+		Field const s2 = _b.y * z * z1z1;
+		Field const h = u2 - u1;
+		Field const r = (s2 - s1).dbl();
+		if (h.isZero())
+			return r.isZero() ? dbl() : zero();
+		Field const i = h.dbl().squared();
+		Field const j = h * i;
+		Field const v = u1 * i;
+		Field const x3 = r.squared() - j - v.dbl();
+		Field const y3 = r * (v - x3) - (s1 * j).dbl();
+		Field const z3 = ((z + _b.z).squared() - z1z1 - z2z2) * h;
+		return JacobianPoint(x3, y3, z3);
+	}
+
+	JacobianPoint operator-(JacobianPoint const& _b) const { return *this + -_b; }
+	JacobianPoint& operator+=(JacobianPoint const& _b) { return *this = *this + _b; }
+
+	/// Addition of a point in affine form (Z == 1), madd-2007-bl.
+	JacobianPoint mixedAdd(JacobianPoint const& _b) const
+	{
+		if (_b.isZero())
+			return *this;
+		if (isZero())
+			return _b;
+		Field const z1z1 = z.squared();
+		Field const u2 = _b.x * z1z1;
+		Field const s2 = _b.y * z * z1z1;
+		Field const h = u2 - x;
+		Field const r = (s2 - y).dbl();
+		if (h.isZero())
+			return r.isZero() ? dbl() : zero();
+		Field const hh = h.squared();
+		Field const i = hh.dbl().dbl();
+		Field const j = h * i;
+		Field const v = x * i;
+		Field const x3 = r.squared() - j - v.dbl();
+		Field const y3 = r * (v - x3) - (y * j).dbl();
+		Field const z3 = (z + h).squared() - z1z1 - hh;
+		return JacobianPoint(x3, y3, z3);
+	}
+
+	/// Scalar multiplication with a width-5 NAF.
+	template <class Int>
+	JacobianPoint mul(Int const& _k) const
+	{
+		if (isZero() || _k.isZero())
+			return zero();
+
+		int8_t naf[c_maxNafDigits<Int>];
+		size_t const len = wnaf(_k, naf);
+		JacobianPoint table[8];
+		oddMultiples(table);
+
+		JacobianPoint r;
+		for (size_t i = len; i-- > 0;)
+		{
+			r = r.dbl();
+			addNafDigit(r, table, naf[i]);
+		}
+		return r;
+	}
+
+	/// Upper bound on the number of width-5 NAF digits of an Int, which may be
+	/// one digit longer than the scalar.
+	template <class Int>
+	static constexpr size_t c_maxNafDigits = 64 * (Int::limbs + 1);
+
+	/// Width-5 NAF digits of @a _k, least significant first. Non-zero digits
+	/// are odd and in (-16, 16). @returns the number of digits.
+	template <class Int>
+	static size_t wnaf(Int const& _k, int8_t* o_digits)
+	{
+		// Work on a copy with an extra limb as the NAF may be one digit longer.
+		size_t constexpr limbs = Int::limbs + 1;
+		uint64_t k[limbs] = {};
+		for (size_t i = 0; i < Int::limbs; ++i)
+			k[i] = _k.data[i];
+
+		size_t len = 0;
+		while (!isZeroLimbs(k, limbs))
+		{
+			int d = 0;
+			if (k[0] & 1)
+			{
+				d = int(k[0] & 31);
+				if (d >= 16)
+					d -= 32;
+				addSigned(k, limbs, -d);
+			}
+			o_digits[len++] = int8_t(d);
+			for (size_t i = 0; i + 1 < limbs; ++i)
+				k[i] = (k[i] >> 1) | (k[i + 1] << 63);
+			k[limbs - 1] >>= 1;
+		}
+		return len;
+	}
+
+	/// Fills @a o_table with P, 3P, ..., 15P, the multiples of the NAF digits.
+	void oddMultiples(JacobianPoint* o_table) const
+	{
+		o_table[0] = *this;
+		JacobianPoint const twice = dbl();
+		for (size_t i = 1; i < 8; ++i)
+			o_table[i] = o_table[i - 1] + twice;
+	}
+
+	/// io_acc += _d * P for a NAF digit @a _d and the odd multiples of P.
+	static void addNafDigit(JacobianPoint& io_acc, JacobianPoint const* _table, int _d)
+	{
+		if (_d > 0)
+			io_acc += _table[_d / 2];
+		else if (_d < 0)
+			io_acc += -_table[-_d / 2];
+	}
+
+	/// Converts to affine form (Z == 1) unless the point is at infinity.
+	JacobianPoint toAffine() const
+	{
+		if (isZero() || z == Field::one())
+			return *this;
+		Field const zInv = z.inverse();
+		Field const zInv2 = zInv.squared();
+		return JacobianPoint(x * zInv2, y * zInv2 * zInv, Field::one());
+	}
+
+	/// Converts all points to affine form sharing one field inversion.
+	static void batchToAffine(JacobianPoint* io_points, size_t _count)
+	{
+		std::vector<Field> zs;
+		zs.reserve(_count);
+		for (size_t i = 0; i < _count; ++i)
+			if (!io_points[i].isZero())
+				zs.push_back(io_points[i].z);
+		batchInvert(zs);
+		size_t j = 0;
+		for (size_t i = 0; i < _count; ++i)
+			if (!io_points[i].isZero())
+			{
+				Field const zInv = zs[j++];
+				Field const zInv2 = zInv.squared();
+				io_points[i] = JacobianPoint(io_points[i].x * zInv2, io_points[i].y * zInv2 * zInv, Field::one());
+			}
+	}
+
+	static void batchToAffine(std::vector<JacobianPoint>& io_points)
+	{
+		batchToAffine(io_points.data(), io_points.size());
+	}
+
+	Field x;
+	Field y;
+	Field z;
+
+private:
+	static bool isZeroLimbs(uint64_t const* _k, size_t _limbs)
+	{
+		for (size_t i = 0; i < _limbs; ++i)
+			if (_k[i])
+				return false;
+		return true;
+	}
+
+	/// io_k += _d for small signed _d, assuming no overflow or underflow.
+	static void addSigned(uint64_t* io_k, size_t _limbs, int _d)
+	{
+		if (_d >= 0)
+		{
+			uint64_t carry = uint64_t(_d);
+			for (size_t i = 0; i < _limbs && carry; ++i)
+			{
+				io_k[i] += carry;
+				carry = io_k[i] < carry;
+			}
+		}
+		else
+		{
+			uint64_t borrow = uint64_t(-_d);
+			for (size_t i = 0; i < _limbs && borrow; ++i)
+			{
+				uint64_t const next = io_k[i] < borrow;
+				io_k[i] -= borrow;
+				borrow = next;
+			}
+		}
+	}
+};
+
+/// Sum of many points in affine form (Z == 1). The points are added pairwise in
+/// affine coordinates, level by level, and all slope denominators of a level
+/// share one batched inversion, which makes an addition cost about 6
+/// multiplications instead of the 11 of a mixed Jacobian addition.
+template <class Point>
+Point batchAffineSum(std::vector<Point> _points)
+{
+	using Field = typename Point::FieldType;
+
+	_points.erase(
+		std::remove_if(_points.begin(), _points.end(), [](Point const& _p) { return _p.isZero(); }),
+		_points.end()
+	);
+	std::vector<Field> denominators;
+	std::vector<Point> next;
+	while (_points.size() > 1)
+	{
+		size_t const pairs = _points.size() / 2;
+		denominators.resize(pairs);
+		for (size_t i = 0; i < pairs; ++i)
+		{
+			Point const& a = _points[2 * i];
+			Point const& b = _points[2 * i + 1];
+			if (a.x != b.x)
+				denominators[i] = b.x - a.x;
+			else if (a.y == b.y)
+				denominators[i] = a.y.dbl();
+			else
+				// P + (-P); keeps the batch free of zeros.
+				denominators[i] = Field::one();
+		}
+		batchInvert(denominators);
+
+		next.clear();
+		for (size_t i = 0; i < pairs; ++i)
+		{
+			Point const& a = _points[2 * i];
+			Point const& b = _points[2 * i + 1];
+			Field lambda;
+			if (a.x != b.x)
+				lambda = (b.y - a.y) * denominators[i];
+			else if (a.y == b.y)
+			{
+				Field const xx = a.x.squared();
+				lambda = (xx.dbl() + xx) * denominators[i];
+			}
+			else
+				continue;
+			Field const x = lambda.squared() - a.x - b.x;
+			next.push_back(Point::fromAffine(x, lambda * (a.x - x) - a.y));
+		}
+		if (_points.size() % 2)
+			next.push_back(_points.back());
+		_points.swap(next);
+	}
+	return _points.empty() ? Point::zero() : _points.front();
+}
+
+/// Precomputed multiples d * 2^(c * i) * P, 0 < d < 2^c, of a fixed base P for
+/// every c bit window i of the scalar, in affine form. A scalar multiplication
+/// then costs one mixed addition per non-zero window and no doublings.
+template <class Point>
+class FixedBaseTable
+{
+public:
+	FixedBaseTable() = default;
+
+	FixedBaseTable(Point const& _base, size_t _scalarBits, unsigned _windowBits = 4):
+		m_windowBits(_windowBits),
+		m_windows((_scalarBits + _windowBits - 1) / _windowBits),
+		m_digits((size_t(1) << _windowBits) - 1)
+	{
+		m_table.reserve(m_windows * m_digits);
+		Point windowBase = _base;
+		for (size_t i = 0; i < m_windows; ++i)
+		{
+			Point multiple = windowBase;
+			for (size_t d = 0; d < m_digits; ++d)
+			{
+				m_table.push_back(multiple);
+				multiple += windowBase;
+			}
+			// multiple == 2^c * windowBase
+			windowBase = multiple;
+		}
+		Point::batchToAffine(m_table);
+	}
+
+	bool empty() const { return m_table.empty(); }
+
+	/// io_acc += _k * P. @a _k must not be wider than the scalar bits of the table.
+	template <class Int>
+	void mulAdd(Int const& _k, Point& io_acc) const
+	{
+		for (size_t i = 0; i < m_windows; ++i)
+			if (size_t const d = _k.window(i * m_windowBits, m_windowBits))
+				io_acc = io_acc.mixedAdd(m_table[i * m_digits + d - 1]);
+	}
+
+	template <class Int>
+	Point mul(Int const& _k) const
+	{
+		Point r = Point::zero();
+		mulAdd(_k, r);
+		return r;
+	}
+
+private:
+	unsigned m_windowBits = 0;
+	size_t m_windows = 0;
+	size_t m_digits = 0;
+	std::vector<Point> m_table;
+};
+
+/// Converts the G1 points of @a _count pairing pairs (io_p[i], io_q[i]) to
+/// affine form and moves the pairs whose G1 point is zero or whose prepared
+/// G2 point has no lines, which contribute a factor of one, out of the front.
+/// @returns the number of pairs left at the front for the Miller loop.
+template <class G1, class G2Prepared>
+size_t compactPairs(G1* io_p, G2Prepared const** io_q, size_t _count)
+{
+	G1::batchToAffine(io_p, _count);
+	size_t count = 0;
+	for (size_t i = 0; i < _count; ++i)
+		if (!io_p[i].isZero() && !io_q[i]->coeffs.empty())
+		{
+			io_p[count] = io_p[i];
+			io_q[count] = io_q[i];
+			++count;
+		}
+	return count;
+}
+
+}
+}
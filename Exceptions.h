@@ -31,5 +31,18 @@ namespace crypto
 /// Rare malfunction of cryptographic functions.
 DEV_SIMPLE_EXCEPTION(CryptoException);
 
+/// A KZG trusted setup file that is missing, truncated or malformed.
+DEV_SIMPLE_EXCEPTION(InvalidTrustedSetup);
+
+/// An encoded curve point that is malformed or does not lie on the curve.
+DEV_SIMPLE_EXCEPTION(InvalidPointEncoding);
+
+/// An NTT domain whose size is not a power of two the field supports.
+DEV_SIMPLE_EXCEPTION(InvalidDomainSize);
+
+/// A Poseidon width, input count or Merkle tree arity outside the supported
+/// parameter sets.
+DEV_SIMPLE_EXCEPTION(InvalidPoseidonWidth);
+
 }
 }
@@ -0,0 +1,46 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2014-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+
+#include <libdevcrypto/Groth16.h>
+
+using namespace std;
+using namespace dev;
+using namespace dev::crypto;
+using namespace dev::crypto::alt_bn128;
+
+Groth16Verifier::Groth16Verifier(Groth16VerifyingKey const& _vk):
+	m_alphaBeta(Fq12::one()),
+	m_gamma(prepareG2OrEmpty(_vk.gamma)),
+	m_delta(prepareG2OrEmpty(_vk.delta)),
+	m_ic0(_vk.ic.empty() ? G1::zero() : _vk.ic.front().toAffine())
+{
+	if (!_vk.alpha.isZero() && !_vk.beta.isZero())
+	{
+		G1 const alpha = _vk.alpha.toAffine();
+		G2Prepared const beta = prepareG2(_vk.beta.toAffine());
+		m_alphaBeta = finalExponentiation(multiMillerLoop(&alpha, &beta, 1));
+	}
+	for (size_t i = 1; i < _vk.ic.size(); ++i)
+		m_icTables.emplace_back(_vk.ic[i], Fr::c_modulus.numBits());
+}
+
+bool Groth16Verifier::verify(Groth16Proof const& _proof, vector<Fr> const& _publicInputs) const
+{
+	if (_publicInputs.size() != m_icTables.size())
+		return false;
+	if (!_proof.a.isOnCurve() || !_proof.c.isOnCurve())
+		return false;
+	if (!_proof.b.isOnCurve() || !isInG2Subgroup(_proof.b))
+		return false;
+
+	G1 vkX = m_ic0;
+	for (size_t i = 0; i < _publicInputs.size(); ++i)
+		m_icTables[i].mulAdd(_publicInputs[i].toCanonical(), vkX);
+
+	// e(A, B) * e(-vk_x, gamma) * e(-C, delta) == e(alpha, beta)
+	G1 points[3] = {_proof.a, -vkX, -_proof.c};
+	G2Prepared const b = prepareG2OrEmpty(_proof.b);
+	G2Prepared const* lines[3] = {&b, &m_gamma, &m_delta};
+	return finalExponentiation(multiMillerLoopSkippingZero(points, lines, 3)) == m_alphaBeta;
+}
@@ -0,0 +1,67 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2014-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+/** @file Groth16.h
+ * Verification of Groth16 proofs over alt_bn128.
+ */
+
+#pragma once
+
+#include "Bn254.h"
+
+#include <vector>
+
+namespace dev
+{
+namespace crypto
+{
+namespace alt_bn128
+{
+
+struct Groth16VerifyingKey
+{
+	G1 alpha;
+	G2 beta;
+	G2 gamma;
+	G2 delta;
+	/// IC[0] followed by one point per public input.
+	std::vector<G1> ic;
+};
+
+struct Groth16Proof
+{
+	G1 a;
+	G2 b;
+	G1 c;
+};
+
+/// Verifies Groth16 proofs against a fixed verifying key, checking
+/// e(A, B) == e(alpha, beta) * e(IC[0] + sum_i x_i * IC[i + 1], gamma) * e(C, delta).
+///
+/// The constructor does all work that depends only on the key: e(alpha, beta),
+/// the Miller loop lines of gamma and delta and fixed-base tables of the IC
+/// points. verify() then costs a fixed-base MSM, a 3-pair Miller loop and a
+/// single final exponentiation.
+class Groth16Verifier
+{
+public:
+	/// @a _vk must consist of valid group elements with at least one IC point.
+	explicit Groth16Verifier(Groth16VerifyingKey const& _vk);
+
+	size_t inputCount() const { return m_icTables.size(); }
+
+	/// @returns false if the proof is invalid, its points are not valid group
+	/// elements or the number of public inputs does not match the key.
+	bool verify(Groth16Proof const& _proof, std::vector<Fr> const& _publicInputs) const;
+
+private:
+	Fq12 m_alphaBeta;
+	G2Prepared m_gamma;
+	G2Prepared m_delta;
+	G1 m_ic0;
+	std::vector<FixedBaseTable<G1>> m_icTables;
+};
+
+}
+}
+}
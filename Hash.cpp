@@ -22,6 +22,9 @@
 #include "Hash.h"
 #include <hash.h>
 
+#include <algorithm>
+#include <iterator>
+
 using namespace dev;
 
 namespace dev
@@ -437,4 +440,149 @@ h160 ripemd160(bytesConstRef _input)
 #undef BYTES_TO_DWORD
 #undef RMDsize
 
+bytes expandMessageXmd(bytesConstRef _message, bytesConstRef _dst, size_t _length)
+{
+	size_t constexpr hashSize = 32;
+	size_t constexpr blockSize = 64;
+	size_t const blocks = (_length + hashSize - 1) / hashSize;
+	if (blocks == 0 || blocks > 255)
+		return {};
+
+	h256 hashedDst;
+	if (_dst.size() > 255)
+	{
+		static char const c_oversizePrefix[] = "H2C-OVERSIZE-DST-";
+		secp256k1_sha256 ctx;
+		secp256k1_sha256_initialize(&ctx);
+		secp256k1_sha256_write(&ctx, reinterpret_cast<byte const*>(c_oversizePrefix), sizeof(c_oversizePrefix) - 1);
+		secp256k1_sha256_write(&ctx, _dst.data(), _dst.size());
+		secp256k1_sha256_finalize(&ctx, hashedDst.data());
+		_dst = bytesConstRef(hashedDst.data(), hashedDst.size);
+	}
+	// DST_prime = DST | I2OSP(len(DST), 1)
+	byte const dstSize = byte(_dst.size());
+	auto writeDstPrime = [&](secp256k1_sha256& _ctx) {
+		secp256k1_sha256_write(&_ctx, _dst.data(), _dst.size());
+		secp256k1_sha256_write(&_ctx, &dstSize, 1);
+	};
+
+	// b_0 = H(Z_pad | msg | I2OSP(len, 2) | I2OSP(0, 1) | DST_prime)
+	byte const zeroPad[blockSize] = {};
+	byte const lengthSuffix[] = {byte(_length >> 8), byte(_length), 0};
+	h256 b0;
+	secp256k1_sha256 ctx;
+	secp256k1_sha256_initialize(&ctx);
+	secp256k1_sha256_write(&ctx, zeroPad, blockSize);
+	secp256k1_sha256_write(&ctx, _message.data(), _message.size());
+	secp256k1_sha256_write(&ctx, lengthSuffix, sizeof(lengthSuffix));
+	writeDstPrime(ctx);
+	secp256k1_sha256_finalize(&ctx, b0.data());
+
+	// b_1 = H(b_0 | I2OSP(1, 1) | DST_prime),
+	// b_i = H(strxor(b_0, b_(i - 1)) | I2OSP(i, 1) | DST_prime)
+	bytes out(blocks * hashSize);
+	h256 chained = b0;
+	for (size_t i = 1; i <= blocks; ++i)
+	{
+		byte* const bi = out.data() + (i - 1) * hashSize;
+		byte const index = byte(i);
+		secp256k1_sha256_initialize(&ctx);
+		secp256k1_sha256_write(&ctx, chained.data(), hashSize);
+		secp256k1_sha256_write(&ctx, &index, 1);
+		writeDstPrime(ctx);
+		secp256k1_sha256_finalize(&ctx, bi);
+		for (size_t j = 0; j < hashSize; ++j)
+			chained[j] = b0[j] ^ bi[j];
+	}
+	out.resize(_length);
+	return out;
+}
+
+namespace keccak
+{
+
+uint64_t const c_roundConstants[24] = {
+	0x0000000000000001, 0x0000000000008082, 0x800000000000808a, 0x8000000080008000,
+	0x000000000000808b, 0x0000000080000001, 0x8000000080008081, 0x8000000000008009,
+	0x000000000000008a, 0x0000000000000088, 0x0000000080008009, 0x000000008000000a,
+	0x000000008000808b, 0x800000000000008b, 0x8000000000008089, 0x8000000000008003,
+	0x8000000000008002, 0x8000000000000080, 0x000000000000800a, 0x800000008000000a,
+	0x8000000080008081, 0x8000000000008080, 0x0000000080000001, 0x8000000080008008,
+};
+
+/// Rotations and destination lanes of the rho and pi steps, in the order
+/// in which pi visits the lanes starting from lane 1.
+unsigned const c_rotations[24] = {1, 3, 6, 10, 15, 21, 28, 36, 45, 55, 2, 14, 27, 41, 56, 8, 25, 43, 62, 18, 39, 61, 20, 44};
+unsigned const c_lanes[24] = {10, 7, 11, 17, 18, 3, 5, 16, 8, 21, 24, 4, 15, 23, 19, 13, 12, 2, 20, 14, 22, 9, 6, 1};
+
+inline uint64_t rotl(uint64_t _x, unsigned _n)
+{
+	return (_x << _n) | (_x >> (64 - _n));
+}
+
+/// The Keccak-f[1600] permutation.
+void permute(uint64_t* io_a)
+{
+	for (uint64_t roundConstant: c_roundConstants)
+	{
+		uint64_t c[5];
+		for (unsigned x = 0; x < 5; ++x)
+			c[x] = io_a[x] ^ io_a[x + 5] ^ io_a[x + 10] ^ io_a[x + 15] ^ io_a[x + 20];
+		for (unsigned x = 0; x < 5; ++x)
+		{
+			uint64_t const d = c[(x + 4) % 5] ^ rotl(c[(x + 1) % 5], 1);
+			for (unsigned y = 0; y < 25; y += 5)
+				io_a[y + x] ^= d;
+		}
+
+		uint64_t carried = io_a[1];
+		for (unsigned i = 0; i < 24; ++i)
+		{
+			uint64_t const next = io_a[c_lanes[i]];
+			io_a[c_lanes[i]] = rotl(carried, c_rotations[i]);
+			carried = next;
+		}
+
+		for (unsigned y = 0; y < 25; y += 5)
+		{
+			for (unsigned x = 0; x < 5; ++x)
+				c[x] = io_a[y + x];
+			for (unsigned x = 0; x < 5; ++x)
+				io_a[y + x] ^= ~c[(x + 1) % 5] & c[(x + 2) % 5];
+		}
+		io_a[0] ^= roundConstant;
+	}
+}
+
+}
+
+Keccak256& Keccak256::update(bytesConstRef _data)
+{
+	for (byte b: _data)
+	{
+		m_state[m_offset / 8] ^= uint64_t(b) << (8 * (m_offset % 8));
+		if (++m_offset == c_rate)
+		{
+			keccak::permute(m_state);
+			m_offset = 0;
+		}
+	}
+	return *this;
+}
+
+h256 Keccak256::digest() const
+{
+	// Original Keccak padding 0x01 ... 0x80, not the 0x06 of SHA-3.
+	uint64_t state[25];
+	std::copy(std::begin(m_state), std::end(m_state), state);
+	state[m_offset / 8] ^= uint64_t(0x01) << (8 * (m_offset % 8));
+	state[(c_rate - 1) / 8] ^= uint64_t(0x80) << (8 * ((c_rate - 1) % 8));
+	keccak::permute(state);
+
+	h256 hash;
+	for (size_t i = 0; i < hash.size; ++i)
+		hash[i] = byte(state[i / 8] >> (8 * (i % 8)));
+	return hash;
+}
+
 }
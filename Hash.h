@@ -33,4 +33,29 @@ h256 sha256(bytesConstRef _input) noexcept;
 
 h160 ripemd160(bytesConstRef _input);
 
+/// expand_message_xmd of RFC 9380 with SHA-256: @a _length uniformly random
+/// bytes derived from a message and a domain separation tag. Tags longer than
+/// 255 bytes are hashed first as the RFC prescribes.
+/// @returns an empty vector if @a _length is zero or above 255 * 32 bytes.
+bytes expandMessageXmd(bytesConstRef _message, bytesConstRef _dst, size_t _length);
+
+/// Incremental Keccak-256, the hash computed by sha3(). The state is a plain
+/// value, so a copy taken after a common prefix hashes inputs that share it
+/// without absorbing the prefix again.
+class Keccak256
+{
+public:
+	Keccak256& update(bytesConstRef _data);
+	/// @returns the hash of all data passed to update() so far and leaves the
+	/// state as it is.
+	h256 digest() const;
+
+private:
+	static size_t constexpr c_rate = 136;
+
+	uint64_t m_state[25] = {};
+	/// Bytes absorbed into the current block.
+	size_t m_offset = 0;
+};
+
 }
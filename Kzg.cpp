@@ -0,0 +1,409 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2014-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+
+#include <libdevcrypto/Kzg.h>
+#include <libdevcrypto/Exceptions.h>
+#include <libdevcrypto/Hash.h>
+#include <libdevcrypto/MultiScalarMul.h>
+
+#include <cstring>
+
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+using namespace dev;
+using namespace dev::crypto;
+using namespace dev::crypto::bls12_381;
+
+class KzgSettings::MappedFile
+{
+public:
+	explicit MappedFile(string const& _path)
+	{
+#ifdef _WIN32
+		ifstream file(_path, ios::binary);
+		if (!file)
+			BOOST_THROW_EXCEPTION(InvalidTrustedSetup());
+		m_buffer.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+		m_data = bytesConstRef(m_buffer.data(), m_buffer.size());
+#else
+		int const fd = ::open(_path.c_str(), O_RDONLY);
+		if (fd < 0)
+			BOOST_THROW_EXCEPTION(InvalidTrustedSetup());
+		struct stat st;
+		if (::fstat(fd, &st) != 0 || st.st_size <= 0)
+		{
+			::close(fd);
+			BOOST_THROW_EXCEPTION(InvalidTrustedSetup());
+		}
+		void* const p = ::mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		::close(fd);
+		if (p == MAP_FAILED)
+			BOOST_THROW_EXCEPTION(InvalidTrustedSetup());
+		m_data = bytesConstRef(static_cast<byte const*>(p), size_t(st.st_size));
+#endif
+	}
+
+	~MappedFile()
+	{
+#ifndef _WIN32
+		::munmap(const_cast<byte*>(m_data.data()), m_data.size());
+#endif
+	}
+
+	bytesConstRef data() const { return m_data; }
+
+private:
+	bytesConstRef m_data;
+#ifdef _WIN32
+	bytes m_buffer;
+#endif
+};
+
+namespace
+{
+
+size_t constexpr c_fqSize = 48;
+size_t constexpr c_frSize = 32;
+size_t constexpr c_g1Size = 2 * c_fqSize;
+size_t constexpr c_g2Size = 4 * c_fqSize;
+size_t constexpr c_compressedG1Size = c_fqSize;
+size_t constexpr c_setupHeaderSize = 24;
+
+char const c_setupMagic[] = "KZGSETUP";
+char const c_challengeDomain[] = "FSBLOBVERIFY_V1_";
+char const c_batchDomain[] = "RCKZGBATCH___V1_";
+
+uint64_t readBigEndian64(byte const* _data)
+{
+	uint64_t v = 0;
+	for (size_t i = 0; i < 8; ++i)
+		v = (v << 8) | _data[i];
+	return v;
+}
+
+void appendBigEndian(bytes& io_data, uint64_t _v, size_t _size)
+{
+	for (size_t i = _size; i-- > 0;)
+		io_data.push_back(i < 8 ? byte(_v >> (8 * i)) : 0);
+}
+
+bool decodeFq(byte const* _data, Fq& o_x)
+{
+	Fq::Int v;
+	v.fromBigEndian(_data, c_fqSize);
+	return Fq::fromCanonical(v, o_x);
+}
+
+bool decodeFr(bytesConstRef _data, Fr& o_x)
+{
+	if (_data.size() != c_frSize)
+		return false;
+	Fr::Int v;
+	v.fromBigEndian(_data.data(), c_frSize);
+	return Fr::fromCanonical(v, o_x);
+}
+
+/// Decodes an uncompressed point of the trusted setup.
+template <class Point>
+bool decodeSetupPoint(byte const* _data, Point& o_p);
+
+template <>
+bool decodeSetupPoint(byte const* _data, G1& o_p)
+{
+	Fq x;
+	Fq y;
+	if (!decodeFq(_data, x) || !decodeFq(_data + c_fqSize, y))
+		return false;
+	o_p = G1::fromAffine(x, y);
+	return o_p.isOnCurve();
+}
+
+template <>
+bool decodeSetupPoint(byte const* _data, G2& o_p)
+{
+	Fq2 x;
+	Fq2 y;
+	if (
+		!decodeFq(_data, x.c0) ||
+		!decodeFq(_data + c_fqSize, x.c1) ||
+		!decodeFq(_data + 2 * c_fqSize, y.c0) ||
+		!decodeFq(_data + 3 * c_fqSize, y.c1)
+	)
+		return false;
+	o_p = G2::fromAffine(x, y);
+	return o_p.isOnCurve();
+}
+
+/// Decodes a compressed G1 point in the ZCash format and checks that it lies in
+/// the subgroup (validate_kzg_g1).
+bool decodeCompressedG1(bytesConstRef _data, G1& o_p)
+{
+	if (_data.size() != c_compressedG1Size)
+		return false;
+	byte const flags = _data[0];
+	bool const compressed = flags & 0x80;
+	bool const infinity = flags & 0x40;
+	bool const largest = flags & 0x20;
+	if (!compressed)
+		return false;
+
+	byte x[c_fqSize];
+	memcpy(x, _data.data(), c_fqSize);
+	x[0] &= 0x1f;
+	if (infinity)
+	{
+		if (largest)
+			return false;
+		for (byte b: x)
+			if (b)
+				return false;
+		o_p = G1::zero();
+		return true;
+	}
+
+	Fq px;
+	Fq py;
+	if (!decodeFq(x, px) || !(px.squared() * px + G1Params::b()).sqrt(py))
+		return false;
+	if (py.isLexicographicallyLargest() != largest)
+		py = -py;
+	o_p = G1::fromAffine(px, py);
+	return isInG1Subgroup(o_p);
+}
+
+Fr hashToField(bytes const& _data)
+{
+	h256 const h = sha256(bytesConstRef(&_data));
+	Fr::Int v;
+	v.fromBigEndian(h.data(), h.size);
+	return Fr::reduce(v);
+}
+
+Fr computeChallenge(bytesConstRef _blob, bytesConstRef _commitment)
+{
+	bytes data(c_challengeDomain, c_challengeDomain + 16);
+	appendBigEndian(data, KzgSettings::c_fieldElementsPerBlob, 16);
+	data += _blob.toBytes();
+	data += _commitment.toBytes();
+	return hashToField(data);
+}
+
+bool blobToPolynomial(bytesConstRef _blob, vector<Fr>& o_polynomial)
+{
+	if (_blob.size() != KzgSettings::c_bytesPerBlob)
+		return false;
+	o_polynomial.resize(KzgSettings::c_fieldElementsPerBlob);
+	for (size_t i = 0; i < o_polynomial.size(); ++i)
+		if (!decodeFr(_blob.cropped(i * c_frSize, c_frSize), o_polynomial[i]))
+			return false;
+	return true;
+}
+
+/// Barycentric evaluation of a polynomial given by its values on the
+/// bit-reversed roots of unity.
+Fr evaluatePolynomial(vector<Fr> const& _polynomial, Fr const& _z, vector<Fr> const& _roots)
+{
+	size_t const n = _polynomial.size();
+	vector<Fr> denominators(n);
+	for (size_t i = 0; i < n; ++i)
+	{
+		if (_z == _roots[i])
+			return _polynomial[i];
+		denominators[i] = _z - _roots[i];
+	}
+	batchInvert(denominators);
+
+	Fr sum = Fr::zero();
+	for (size_t i = 0; i < n; ++i)
+		sum += _polynomial[i] * _roots[i] * denominators[i];
+	BigInt<1> const width{{n}};
+	return sum * (_z.pow(width) - Fr::one()) * Fr(n).inverse();
+}
+
+vector<Fr> computeRootsOfUnity(size_t _n)
+{
+	unsigned bits = 0;
+	while ((size_t(1) << bits) < _n)
+		++bits;
+	// 7 generates the multiplicative group of Fr.
+	Fr const root = Fr(7).pow(bigint::divSmall(bigint::subSmall(Fr::c_modulus, 1), _n));
+	vector<Fr> roots(_n);
+	Fr w = Fr::one();
+	for (size_t i = 0; i < _n; ++i)
+	{
+		size_t reversed = 0;
+		for (unsigned b = 0; b < bits; ++b)
+			reversed |= ((i >> b) & 1) << (bits - 1 - b);
+		roots[reversed] = w;
+		w *= root;
+	}
+	return roots;
+}
+
+/// @returns true if e(_a, [s]_2) * e(_b, G2) == 1.
+bool pairingCheck(KzgSettings const& _settings, G1 const& _a, G1 const& _b)
+{
+	G1 points[2] = {_a, _b};
+	G2Prepared const* lines[2] = {&_settings.s2(), &_settings.g2()};
+	return finalExponentiation(multiMillerLoopSkippingZero(points, lines, 2)).isOne();
+}
+
+/// verify_kzg_proof_batch: with powers r^i of a challenge r checks
+/// e(sum r^i proof_i, -[s]_2) * e(sum r^i (C_i - y_i G1 + z_i proof_i), G2) == 1.
+bool verifyProofBatch(
+	KzgSettings const& _settings,
+	vector<G1> const& _commitments,
+	vector<Fr> const& _zs,
+	vector<Fr> const& _ys,
+	vector<G1> const& _proofs,
+	vector<bytesConstRef> const& _commitmentBytes,
+	vector<bytesConstRef> const& _proofBytes
+)
+{
+	size_t const n = _commitments.size();
+	bytes data(c_batchDomain, c_batchDomain + 16);
+	appendBigEndian(data, KzgSettings::c_fieldElementsPerBlob, 8);
+	appendBigEndian(data, n, 8);
+	for (size_t i = 0; i < n; ++i)
+	{
+		data += _commitmentBytes[i].toBytes();
+		size_t const offset = data.size();
+		data.resize(offset + 2 * c_frSize);
+		_zs[i].toCanonical().toBigEndian(data.data() + offset, c_frSize);
+		_ys[i].toCanonical().toBigEndian(data.data() + offset + c_frSize, c_frSize);
+		data += _proofBytes[i].toBytes();
+	}
+	Fr const r = hashToField(data);
+
+	vector<G1> proofPoints;
+	vector<Fr::Int> proofScalars;
+	vector<G1> sumPoints;
+	vector<Fr::Int> sumScalars;
+	Fr weightedY = Fr::zero();
+	Fr power = Fr::one();
+	for (size_t i = 0; i < n; ++i)
+	{
+		if (!_proofs[i].isZero())
+		{
+			proofPoints.push_back(_proofs[i]);
+			proofScalars.push_back(power.toCanonical());
+			sumPoints.push_back(_proofs[i]);
+			sumScalars.push_back((power * _zs[i]).toCanonical());
+		}
+		if (!_commitments[i].isZero())
+		{
+			sumPoints.push_back(_commitments[i]);
+			sumScalars.push_back(power.toCanonical());
+		}
+		weightedY += power * _ys[i];
+		power *= r;
+	}
+	sumPoints.push_back(g1Generator());
+	sumScalars.push_back((-weightedY).toCanonical());
+
+	G1 const proofSum = multiScalarMul(move(proofPoints), proofScalars);
+	G1 const sum = multiScalarMul(move(sumPoints), sumScalars);
+	return pairingCheck(_settings, -proofSum, sum);
+}
+
+}
+
+KzgSettings::KzgSettings(string const& _path):
+	m_file(new MappedFile(_path))
+{
+	bytesConstRef const data = m_file->data();
+	if (data.size() < c_setupHeaderSize || memcmp(data.data(), c_setupMagic, 8) != 0)
+		BOOST_THROW_EXCEPTION(InvalidTrustedSetup());
+	uint64_t const g1Count = readBigEndian64(data.data() + 8);
+	uint64_t const g2Count = readBigEndian64(data.data() + 16);
+	size_t const g1Bytes = c_fieldElementsPerBlob * c_g1Size;
+	if (
+		g1Count != c_fieldElementsPerBlob ||
+		g2Count < 2 ||
+		data.size() < c_setupHeaderSize + g1Bytes ||
+		(data.size() - c_setupHeaderSize - g1Bytes) / c_g2Size != g2Count ||
+		(data.size() - c_setupHeaderSize - g1Bytes) % c_g2Size != 0
+	)
+		BOOST_THROW_EXCEPTION(InvalidTrustedSetup());
+	m_g1 = data.cropped(c_setupHeaderSize, g1Bytes);
+
+	// Only [s]_2 takes part in verification; the G1 points are decoded on demand.
+	G2 s;
+	if (!decodeSetupPoint(m_g1.data() + g1Bytes + c_g2Size, s) || s.isZero() || !isInG2Subgroup(s))
+		BOOST_THROW_EXCEPTION(InvalidTrustedSetup());
+	m_s2 = prepareG2(s);
+	m_g2 = prepareG2(g2Generator());
+	m_roots = computeRootsOfUnity(c_fieldElementsPerBlob);
+}
+
+KzgSettings::~KzgSettings() = default;
+
+bool KzgSettings::g1Lagrange(size_t _i, G1& o_p) const
+{
+	return _i < c_fieldElementsPerBlob && decodeSetupPoint(m_g1.data() + _i * c_g1Size, o_p);
+}
+
+bool dev::crypto::kzg_verify_proof(
+	KzgSettings const& _settings,
+	bytesConstRef _commitment,
+	bytesConstRef _z,
+	bytesConstRef _y,
+	bytesConstRef _proof
+)
+{
+	G1 commitment;
+	G1 proof;
+	Fr z;
+	Fr y;
+	if (
+		!decodeCompressedG1(_commitment, commitment) ||
+		!decodeCompressedG1(_proof, proof) ||
+		!decodeFr(_z, z) ||
+		!decodeFr(_y, y)
+	)
+		return false;
+
+	// e(C - [y]_1, G2) == e(proof, [s]_2 - [z]_2)
+	// <=> e(-proof, [s]_2) * e(C - [y]_1 + z proof, G2) == 1
+	G1 const rhs = commitment - g1Generator().mul(y.toCanonical()) + proof.mul(z.toCanonical());
+	return pairingCheck(_settings, -proof, rhs);
+}
+
+bool dev::crypto::kzg_verify_blob_proof_batch(
+	KzgSettings const& _settings,
+	vector<bytesConstRef> const& _blobs,
+	vector<bytesConstRef> const& _commitments,
+	vector<bytesConstRef> const& _proofs
+)
+{
+	size_t const n = _blobs.size();
+	if (_commitments.size() != n || _proofs.size() != n)
+		return false;
+
+	vector<G1> commitments(n);
+	vector<G1> proofs(n);
+	vector<Fr> zs(n);
+	vector<Fr> ys(n);
+	vector<Fr> polynomial;
+	for (size_t i = 0; i < n; ++i)
+	{
+		if (
+			!decodeCompressedG1(_commitments[i], commitments[i]) ||
+			!decodeCompressedG1(_proofs[i], proofs[i]) ||
+			!blobToPolynomial(_blobs[i], polynomial)
+		)
+			return false;
+		zs[i] = computeChallenge(_blobs[i], _commitments[i]);
+		ys[i] = evaluatePolynomial(polynomial, zs[i], _settings.rootsOfUnity());
+	}
+	return verifyProofBatch(_settings, commitments, zs, ys, proofs, _commitments, _proofs);
+}
@@ -0,0 +1,85 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2014-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+/** @file Kzg.h
+ * KZG polynomial commitment verification over BLS12-381 (EIP-4844).
+ */
+
+#pragma once
+
+#include <libdevcrypto/Bls12381.h>
+
+#include <libdevcore/Common.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace dev
+{
+namespace crypto
+{
+
+/// The EIP-4844 trusted setup, mapped into memory from a binary file instead
+/// of being parsed from hex at startup.
+///
+/// File layout, all numbers big-endian:
+///   "KZGSETUP" | G1 point count (8 bytes) | G2 point count (8 bytes)
+///   G1 points in Lagrange form, bit-reversed order: x | y, 48 bytes each
+///   G2 points in monomial form: x.c0 | x.c1 | y.c0 | y.c1, 48 bytes each
+class KzgSettings
+{
+public:
+	static size_t constexpr c_fieldElementsPerBlob = 4096;
+	static size_t constexpr c_bytesPerBlob = 32 * c_fieldElementsPerBlob;
+
+	/// Maps the setup at @a _path. Throws InvalidTrustedSetup on failure.
+	explicit KzgSettings(std::string const& _path);
+	~KzgSettings();
+
+	/// Decodes the Lagrange basis point @a _i, i.e. [L_i(s)]_1.
+	/// @returns false if the stored point is not on the curve.
+	bool g1Lagrange(size_t _i, bls12_381::G1& o_p) const;
+
+	/// Roots of unity of the evaluation domain in bit-reversed order.
+	std::vector<bls12_381::Fr> const& rootsOfUnity() const { return m_roots; }
+	/// Lines of [s]_2 for the Miller loop.
+	bls12_381::G2Prepared const& s2() const { return m_s2; }
+	/// Lines of the G2 generator for the Miller loop.
+	bls12_381::G2Prepared const& g2() const { return m_g2; }
+
+private:
+	class MappedFile;
+
+	std::unique_ptr<MappedFile> m_file;
+	bytesConstRef m_g1;
+	std::vector<bls12_381::Fr> m_roots;
+	bls12_381::G2Prepared m_s2;
+	bls12_381::G2Prepared m_g2;
+};
+
+/// Verifies a proof that the polynomial committed to by @a _commitment takes
+/// the value @a _y at @a _z (verify_kzg_proof). Commitment and proof are
+/// compressed G1 points (48 bytes), @a _z and @a _y big-endian field elements.
+/// @returns false for invalid encodings as well as for invalid proofs.
+bool kzg_verify_proof(
+	KzgSettings const& _settings,
+	bytesConstRef _commitment,
+	bytesConstRef _z,
+	bytesConstRef _y,
+	bytesConstRef _proof
+);
+
+/// Verifies blob proofs of many blobs at once (verify_blob_kzg_proof_batch).
+/// The claims are combined with powers of a Fiat-Shamir challenge into two
+/// MSMs and a single 2-pair pairing check.
+/// @returns false for invalid encodings as well as for invalid proofs.
+bool kzg_verify_blob_proof_batch(
+	KzgSettings const& _settings,
+	std::vector<bytesConstRef> const& _blobs,
+	std::vector<bytesConstRef> const& _commitments,
+	std::vector<bytesConstRef> const& _proofs
+);
+
+}
+}
@@ -16,186 +16,1199 @@
  */
 
 #include <libdevcrypto/LibSnark.h>
+#include <libdevcrypto/Bn254.h>
+#include <libdevcrypto/Exceptions.h>
+#include <libdevcrypto/MultiScalarMul.h>
 
-#include <algebra/curves/alt_bn128/alt_bn128_g1.hpp>
-#include <algebra/curves/alt_bn128/alt_bn128_g2.hpp>
-#include <algebra/curves/alt_bn128/alt_bn128_pairing.hpp>
-#include <algebra/curves/alt_bn128/alt_bn128_pp.hpp>
-#include <common/profiling.hpp>
-
-#include <libdevcore/Exceptions.h>
+#include <libdevcore/Guards.h>
 #include <libdevcore/Log.h>
+#include <libdevcore/SHA3.h>
+
+#include <algorithm>
+#include <cassert>
+#include <list>
+#include <thread>
+#include <unordered_map>
 
 using namespace std;
 using namespace dev;
 using namespace dev::crypto;
+using namespace dev::crypto::alt_bn128;
 
 namespace
 {
 
-DEV_SIMPLE_EXCEPTION(InvalidEncoding);
+/// Scalars of the G1 multiplications are arbitrary 256 bit numbers.
+using Scalar = BigInt<4>;
+
+Scalar decodeScalar(dev::bytesConstRef _data)
+{
+	// h256::AlignLeft ensures that the h256 is zero-filled on the right if _data
+	// is too short.
+	h256 const sbin(_data, h256::AlignLeft);
+	Scalar s;
+	s.fromBigEndian(sbin.data(), sbin.size);
+	return s;
+}
+
+// The decoders report invalid input through their return value rather than
+// an exception: invalid points are cheap to submit, so rejecting them must be
+// cheap as well.
+
+/// @returns false if the encoded number is not smaller than the modulus.
+bool decodeFqElement(dev::bytesConstRef _data, Fq& o_x)
+{
+	return Fq::fromCanonical(decodeScalar(_data), o_x);
+}
 
-void initLibSnark() noexcept
+/// @returns false if the encoding is invalid or the point is not on the curve.
+bool decodePointG1(dev::bytesConstRef _data, G1& o_p)
 {
-	static bool s_initialized = []() noexcept
+	Fq x;
+	Fq y;
+	if (!decodeFqElement(_data.cropped(0), x) || !decodeFqElement(_data.cropped(32), y))
+		return false;
+	if (x.isZero() && y.isZero())
 	{
-		libff::inhibit_profiling_info = true;
-		libff::inhibit_profiling_counters = true;
-		libff::alt_bn128_pp::init_public_params();
+		o_p = G1::zero();
 		return true;
-	}();
-	(void)s_initialized;
+	}
+	o_p = G1::fromAffine(x, y);
+	return o_p.isOnCurve();
 }
 
-libff::bigint<libff::alt_bn128_q_limbs> toLibsnarkBigint(h256 const& _x)
+/// Encodes a point that is already in affine form (Z == 1).
+bytes encodeAffinePointG1(G1 const& _p)
 {
-	libff::bigint<libff::alt_bn128_q_limbs> b;
-	auto const N = b.N;
-	constexpr size_t L = sizeof(b.data[0]);
-	static_assert(sizeof(mp_limb_t) == L, "Unexpected limb size in libff::bigint.");
-	for (size_t i = 0; i < N; i++)
-		for (size_t j = 0; j < L; j++)
-			b.data[N - 1 - i] |= mp_limb_t(_x[i * L + j]) << (8 * (L - 1 - j));
-	return b;
+	bytes out(64);
+	_p.x.toCanonical().toBigEndian(out.data(), 32);
+	_p.y.toCanonical().toBigEndian(out.data() + 32, 32);
+	return out;
 }
 
-h256 fromLibsnarkBigint(libff::bigint<libff::alt_bn128_q_limbs> const& _b)
+bytes encodePointG1(G1 const& _p)
 {
-	static size_t const N = static_cast<size_t>(_b.N);
-	static size_t const L = sizeof(_b.data[0]);
-	static_assert(sizeof(mp_limb_t) == L, "Unexpected limb size in libff::bigint.");
-	h256 x;
-	for (size_t i = 0; i < N; i++)
-		for (size_t j = 0; j < L; j++)
-			x[i * L + j] = uint8_t(_b.data[N - 1 - i] >> (8 * (L - 1 - j)));
-	return x;
+	if (_p.isZero())
+		return bytes(64, 0);
+	return encodeAffinePointG1(_p.toAffine());
 }
 
-libff::alt_bn128_Fq decodeFqElement(dev::bytesConstRef _data)
+/// Writes the 64 byte encoding of @a _p to @a o_out.
+void encodePointG1(G1 const& _p, byte* o_out)
+{
+	if (_p.isZero())
+	{
+		fill(o_out, o_out + 64, 0);
+		return;
+	}
+	G1 const a = _p.toAffine();
+	a.x.toCanonical().toBigEndian(o_out, 32);
+	a.y.toCanonical().toBigEndian(o_out + 32, 32);
+}
+
+bool decodeFq2Element(dev::bytesConstRef _data, Fq2& o_x)
+{
+	// Encoding: c1 (256 bits) c0 (256 bits)
+	// "Big endian", just like the numbers
+	return
+		decodeFqElement(_data.cropped(32), o_x.c0) &&
+		decodeFqElement(_data.cropped(0), o_x.c1);
+}
+
+/// @returns false if the encoding is invalid or the point is not on the twist.
+bool decodePointG2(dev::bytesConstRef _data, G2& o_p)
+{
+	Fq2 x;
+	Fq2 y;
+	if (!decodeFq2Element(_data, x) || !decodeFq2Element(_data.cropped(64), y))
+		return false;
+	if (x.isZero() && y.isZero())
+	{
+		o_p = G2::zero();
+		return true;
+	}
+	o_p = G2::fromAffine(x, y);
+	return o_p.isOnCurve();
+}
+
+// Compressed encodings carry x only, with two flags in the most significant
+// bits, which are always zero in an element of Fq.
+size_t constexpr c_compressedG1Size = 32;
+size_t constexpr c_compressedG2Size = 64;
+byte constexpr c_flagLargest = 0x80;
+byte constexpr c_flagInfinity = 0x40;
+byte constexpr c_flagMask = c_flagLargest | c_flagInfinity;
+
+/// Decodes an element of Fq whose first byte carries the flags of a
+/// compressed encoding.
+bool decodeFlaggedFqElement(dev::bytesConstRef _data, byte& o_flags, Fq& o_x)
 {
-	// h256::AlignLeft ensures that the h256 is zero-filled on the right if _data
-	// is too short.
 	h256 xbin(_data, h256::AlignLeft);
-	// TODO: Consider using a compiler time constant for comparison.
-	if (u256(xbin) >= u256(fromLibsnarkBigint(libff::alt_bn128_Fq::mod)))
-		BOOST_THROW_EXCEPTION(InvalidEncoding());
-	return toLibsnarkBigint(xbin);
+	o_flags = xbin[0] & c_flagMask;
+	xbin[0] &= ~c_flagMask;
+	Scalar v;
+	v.fromBigEndian(xbin.data(), xbin.size);
+	return Fq::fromCanonical(v, o_x);
 }
 
-libff::alt_bn128_G1 decodePointG1(dev::bytesConstRef _data)
+bool isLexicographicallyLargest(Fq const& _x)
 {
-	libff::alt_bn128_Fq x = decodeFqElement(_data.cropped(0));
-	libff::alt_bn128_Fq y = decodeFqElement(_data.cropped(32));
-	if (x == libff::alt_bn128_Fq::zero() && y == libff::alt_bn128_Fq::zero())
-		return libff::alt_bn128_G1::zero();
-	libff::alt_bn128_G1 p(x, y, libff::alt_bn128_Fq::one());
-	if (!p.is_well_formed())
-		BOOST_THROW_EXCEPTION(InvalidEncoding());
-	return p;
+	return _x.isLexicographicallyLargest();
 }
 
-bytes encodePointG1(libff::alt_bn128_G1 _p)
+/// Fq2 elements are ordered by c1 first.
+bool isLexicographicallyLargest(Fq2 const& _x)
 {
-	if (_p.is_zero())
-		return bytes(64, 0);
-	_p.to_affine_coordinates();
-	return
-		fromLibsnarkBigint(_p.X.as_bigint()).asBytes() +
-		fromLibsnarkBigint(_p.Y.as_bigint()).asBytes();
+	return _x.c1.isZero() ? _x.c0.isLexicographicallyLargest() : _x.c1.isLexicographicallyLargest();
 }
 
-libff::alt_bn128_Fq2 decodeFq2Element(dev::bytesConstRef _data)
+/// y of a compressed point: the root of @a _y2 selected by the flags.
+template <class Field>
+bool decompressY(Field const& _y2, byte _flags, Field& o_y)
 {
-	// Encoding: c1 (256 bits) c0 (256 bits)
-	// "Big endian", just like the numbers
-	return libff::alt_bn128_Fq2(
-		decodeFqElement(_data.cropped(32)),
-		decodeFqElement(_data.cropped(0))
-	);
+	if (!_y2.sqrt(o_y))
+		return false;
+	if (isLexicographicallyLargest(o_y) != bool(_flags & c_flagLargest))
+		o_y = -o_y;
+	return true;
 }
 
-libff::alt_bn128_G2 decodePointG2(dev::bytesConstRef _data)
+/// @returns false if the encoding is invalid or x is not the abscissa of a point.
+bool decompressPointG1(dev::bytesConstRef _data, G1& o_p)
 {
-	libff::alt_bn128_Fq2 const x = decodeFq2Element(_data);
-	libff::alt_bn128_Fq2 const y = decodeFq2Element(_data.cropped(64));
-	if (x == libff::alt_bn128_Fq2::zero() && y == libff::alt_bn128_Fq2::zero())
-		return libff::alt_bn128_G2::zero();
-	libff::alt_bn128_G2 p(x, y, libff::alt_bn128_Fq2::one());
-	if (!p.is_well_formed())
-		BOOST_THROW_EXCEPTION(InvalidEncoding());
-	return p;
+	byte flags;
+	Fq x;
+	if (!decodeFlaggedFqElement(_data.cropped(0, c_compressedG1Size), flags, x))
+		return false;
+	if (flags & c_flagInfinity)
+	{
+		o_p = G1::zero();
+		return flags == c_flagInfinity && x.isZero();
+	}
+	Fq y;
+	if (!decompressY(x.squared() * x + G1Params::b(), flags, y))
+		return false;
+	o_p = G1::fromAffine(x, y);
+	return true;
 }
 
+/// @returns false if the encoding is invalid or x is not the abscissa of a
+/// point of the twist. The point may lie outside the subgroup.
+bool decompressPointG2(dev::bytesConstRef _data, G2& o_p)
+{
+	// Encoding: c1 (with the flags) c0, like the uncompressed one.
+	byte flags;
+	Fq2 x;
+	if (!decodeFlaggedFqElement(_data.cropped(0, 32), flags, x.c1) || !decodeFqElement(_data.cropped(32, 32), x.c0))
+		return false;
+	if (flags & c_flagInfinity)
+	{
+		o_p = G2::zero();
+		return flags == c_flagInfinity && x.isZero();
+	}
+	Fq2 y;
+	if (!decompressY(x.squared() * x + G2Params::b(), flags, y))
+		return false;
+	o_p = G2::fromAffine(x, y);
+	return true;
 }
 
-pair<bool, bytes> dev::crypto::alt_bn128_pairing_product(dev::bytesConstRef _in)
+bytes compressPointG1(G1 const& _p)
 {
-	// Input: list of pairs of G1 and G2 points
-	// Output: 1 if pairing evaluates to 1, 0 otherwise (left-padded to 32 bytes)
+	bytes out(c_compressedG1Size, 0);
+	if (_p.isZero())
+	{
+		out[0] = c_flagInfinity;
+		return out;
+	}
+	G1 const a = _p.toAffine();
+	a.x.toCanonical().toBigEndian(out.data(), 32);
+	if (isLexicographicallyLargest(a.y))
+		out[0] |= c_flagLargest;
+	return out;
+}
 
-	size_t constexpr pairSize = 2 * 32 + 2 * 64;
-	size_t const pairs = _in.size() / pairSize;
-	if (pairs * pairSize != _in.size())
+bytes compressPointG2(G2 const& _p)
+{
+	bytes out(c_compressedG2Size, 0);
+	if (_p.isZero())
+	{
+		out[0] = c_flagInfinity;
+		return out;
+	}
+	G2 const a = _p.toAffine();
+	a.x.c1.toCanonical().toBigEndian(out.data(), 32);
+	a.x.c0.toCanonical().toBigEndian(out.data() + 32, 32);
+	if (isLexicographicallyLargest(a.y))
+		out[0] |= c_flagLargest;
+	return out;
+}
+
+bytes encodePointG2(G2 const& _p)
+{
+	bytes out(128, 0);
+	if (_p.isZero())
+		return out;
+	G2 const a = _p.toAffine();
+	a.x.c1.toCanonical().toBigEndian(out.data(), 32);
+	a.x.c0.toCanonical().toBigEndian(out.data() + 32, 32);
+	a.y.c1.toCanonical().toBigEndian(out.data() + 64, 32);
+	a.y.c0.toCanonical().toBigEndian(out.data() + 96, 32);
+	return out;
+}
+
+/// Decompresses k concatenated points of @a _size bytes and re-encodes them
+/// uncompressed. Large batches are split over threads as every point costs a
+/// square root.
+template <class Point>
+pair<bool, bytes> decompressBatch(
+	dev::bytesConstRef _in,
+	size_t _size,
+	bool (*_decompress)(dev::bytesConstRef, Point&),
+	bytes (*_encode)(Point const&)
+)
+{
+	// Below this number of points spawning threads costs more than it saves.
+	size_t constexpr parallelThreshold = 256;
+
+	size_t const count = _in.size() / _size;
+	if (count * _size != _in.size())
 		// Invalid length.
 		return {false, bytes{}};
 
-	try
+	size_t const encodedSize = 2 * _size;
+	bytes out(count * encodedSize);
+	vector<char> valid(count, 0);
+	auto work = [&](size_t _begin, size_t _end) {
+		for (size_t i = _begin; i < _end; ++i)
+		{
+			Point p;
+			if (!_decompress(_in.cropped(i * _size, _size), p))
+				continue;
+			bytes const encoded = _encode(p);
+			copy(encoded.begin(), encoded.end(), out.begin() + i * encodedSize);
+			valid[i] = 1;
+		}
+	};
+
+	unsigned const threads = count < parallelThreshold ? 1 : max(1u, thread::hardware_concurrency());
+	if (threads == 1)
+		work(0, count);
+	else
+	{
+		vector<thread> workers;
+		size_t const chunk = (count + threads - 1) / threads;
+		for (size_t begin = 0; begin < count; begin += chunk)
+			workers.emplace_back(work, begin, min(count, begin + chunk));
+		for (auto& worker: workers)
+			worker.join();
+	}
+
+	if (find(valid.begin(), valid.end(), 0) != valid.end())
+		return {false, bytes{}};
+	return {true, move(out)};
+}
+
+bool computeG1Add(dev::bytesConstRef _in, G1& o_r)
+{
+	G1 p1;
+	G1 p2;
+	if (!decodePointG1(_in, p1) || !decodePointG1(_in.cropped(32 * 2), p2))
+		return false;
+	o_r = p1 + p2;
+	return true;
+}
+
+/// Fixed-base tables of the G1 bases used more often than a threshold, keyed
+/// by the Keccak-256 hash of the encoded point. Bases below the threshold only
+/// hold a use counter. Entries are kept in LRU order and evicted once tables
+/// and counters together exceed the memory limit.
+class G1MulCache
+{
+public:
+	using Table = shared_ptr<FixedBaseTable<G1> const>;
+
+	/// Counts a use of @a _base and @returns its table, building it on the
+	/// use that passes the threshold, or null while the base is below it.
+	Table lookup(h256 const& _key, G1 const& _base)
 	{
-		initLibSnark();
-		libff::alt_bn128_Fq12 x = libff::alt_bn128_Fq12::one();
-		for (size_t i = 0; i < pairs; ++i)
 		{
-			bytesConstRef const pair = _in.cropped(i * pairSize, pairSize);
-			libff::alt_bn128_G1 const g1 = decodePointG1(pair);
-			libff::alt_bn128_G2 const p = decodePointG2(pair.cropped(2 * 32));
-			if (-libff::alt_bn128_G2::scalar_field::one() * p + p != libff::alt_bn128_G2::zero())
-				// p is not an element of the group (has wrong order)
-				return {false, bytes()};
-			if (p.is_zero() || g1.is_zero())
-				continue; // the pairing is one
-			x = x * libff::alt_bn128_miller_loop(
-				libff::alt_bn128_precompute_G1(g1),
-				libff::alt_bn128_precompute_G2(p)
-			);
+			Guard l(x_cache);
+			if (!m_limit)
+				return {};
+			auto it = m_index.find(_key);
+			if (it == m_index.end())
+			{
+				m_entries.emplace_front(_key, Entry{});
+				it = m_index.emplace(_key, m_entries.begin()).first;
+				m_memory += c_entrySize;
+			}
+			else
+				m_entries.splice(m_entries.begin(), m_entries, it->second);
+			Entry& entry = it->second->second;
+			if (entry.table)
+			{
+				++m_hits;
+				return entry.table;
+			}
+			// A table that does not fit the limit alongside its entry would
+			// be evicted right after being built.
+			bool const build = ++entry.uses > m_threshold && c_entrySize + c_tableSize <= m_limit;
+			evict();
+			if (!build)
+				return {};
+		}
+
+		// Concurrent callers may build the same table; the first one to
+		// return keeps it.
+		Table table = make_shared<FixedBaseTable<G1> const>(_base, 256, c_fixedBaseWindowBits);
+		Guard l(x_cache);
+		auto it = m_index.find(_key);
+		if (it != m_index.end())
+		{
+			Entry& entry = it->second->second;
+			if (entry.table)
+				return entry.table;
+			entry.table = table;
+			m_memory += c_tableSize;
+			++m_builds;
+			evict();
 		}
-		bool const result = libff::alt_bn128_final_exponentiation(x) == libff::alt_bn128_GT::one();
-		return {true, h256{result}.asBytes()};
+		return table;
 	}
-	catch (InvalidEncoding const&)
+
+	void setLimit(size_t _memoryBytes, unsigned _threshold)
+	{
+		Guard l(x_cache);
+		m_limit = _memoryBytes;
+		m_threshold = _threshold;
+		evict();
+	}
+
+	bool enabled() const
 	{
+		Guard l(x_cache);
+		return m_limit != 0;
+	}
+
+	AltBn128G1MulCacheStats stats() const
+	{
+		Guard l(x_cache);
+		size_t const tables = m_builds - m_tablesEvicted;
+		return {m_hits, m_builds, m_evictions, tables, m_entries.size() - tables, m_memory, m_limit};
+	}
+
+private:
+	struct Entry
+	{
+		uint64_t uses = 0;
+		Table table;
+	};
+
+	using Entries = list<pair<h256, Entry>>;
+
+	/// A list node, a hash map node and its bucket.
+	static size_t constexpr c_entrySize = sizeof(Entries::value_type) + 6 * sizeof(void*) + sizeof(h256);
+	static size_t constexpr c_tableSize = sizeof(FixedBaseTable<G1>) +
+		(256 + c_fixedBaseWindowBits - 1) / c_fixedBaseWindowBits * ((1 << c_fixedBaseWindowBits) - 1) * sizeof(G1);
+
+	void evict()
+	{
+		while (m_memory > m_limit && !m_entries.empty())
+		{
+			Entry const& entry = m_entries.back().second;
+			m_memory -= c_entrySize;
+			if (entry.table)
+			{
+				m_memory -= c_tableSize;
+				++m_tablesEvicted;
+			}
+			m_index.erase(m_entries.back().first);
+			m_entries.pop_back();
+			++m_evictions;
+		}
+	}
+
+	mutable Mutex x_cache;
+	size_t m_limit = 0;
+	unsigned m_threshold = c_altBn128G1MulCacheThreshold;
+	size_t m_memory = 0;
+	Entries m_entries;
+	unordered_map<h256, Entries::iterator> m_index;
+	uint64_t m_hits = 0;
+	uint64_t m_builds = 0;
+	uint64_t m_evictions = 0;
+	uint64_t m_tablesEvicted = 0;
+};
+
+G1MulCache& g1MulCache()
+{
+	static G1MulCache s_cache;
+	return s_cache;
+}
+
+bool computeG1Mul(dev::bytesConstRef _in, G1& o_r)
+{
+	G1 p;
+	if (!decodePointG1(_in.cropped(0), p))
+		return false;
+	Scalar const s = decodeScalar(_in.cropped(64));
+
+	G1MulCache& cache = g1MulCache();
+	if (!p.isZero() && cache.enabled())
+	{
+		// h512::AlignLeft zero-pads short inputs like the decoder does.
+		h512 const point(_in, h512::AlignLeft);
+		if (G1MulCache::Table table = cache.lookup(sha3(point.ref()), p))
+		{
+			o_r = table->mul(s);
+			return true;
+		}
+	}
+	o_r = p.mul(s);
+	return true;
+}
+
+bool computeG2Add(dev::bytesConstRef _in, G2& o_r)
+{
+	G2 p1;
+	G2 p2;
+	if (!decodePointG2(_in, p1) || !decodePointG2(_in.cropped(64 * 2), p2))
+		return false;
+	o_r = p1 + p2;
+	return true;
+}
+
+/// Points outside G2 fall back to the plain NAF multiplication, for which
+/// psi is not multiplication by a scalar.
+G2 mulG2Any(G2 const& _p, Scalar const& _s)
+{
+	return isInG2Subgroup(_p) ? mulG2(_p, _s) : _p.mul(_s);
+}
+
+bool computeG2Mul(dev::bytesConstRef _in, G2& o_r)
+{
+	G2 p;
+	if (!decodePointG2(_in.cropped(0), p))
+		return false;
+	o_r = mulG2Any(p, decodeScalar(_in.cropped(128)));
+	return true;
+}
+
+/// Decodes one pair and checks the field range and curve equation of its
+/// points, leaving the G2 subgroup check to the caller.
+bool decodePair(
+	dev::bytesConstRef _g1,
+	dev::bytesConstRef _g2,
+	AltBn128Encoding _encoding,
+	G1& o_g1,
+	G2& o_g2
+)
+{
+	return _encoding == AltBn128Encoding::Compressed ?
+		decompressPointG1(_g1, o_g1) && decompressPointG2(_g2, o_g2) :
+		decodePointG1(_g1, o_g1) && decodePointG2(_g2, o_g2);
+}
+
+/// Decodes the pairs of a pairing input into @a o_g1s and @a o_g2s and
+/// validates all of them before any pairing work is done: the length, the
+/// field range and curve equation of every point, and only then the costlier
+/// G2 subgroup checks. An invalid input thus costs at most its validation,
+/// wherever the bad pair sits. Pairs with a zero point are dropped as their
+/// pairing is one. The vectors keep their capacity.
+bool decodePairs(
+	dev::bytesConstRef _in,
+	AltBn128Encoding _encoding,
+	vector<G1>& o_g1s,
+	vector<G2>& o_g2s
+)
+{
+	// Input: list of pairs of G1 and G2 points
+	bool const compressed = _encoding == AltBn128Encoding::Compressed;
+	size_t const g1Size = compressed ? c_compressedG1Size : 2 * 32;
+	size_t const pairSize = g1Size + (compressed ? c_compressedG2Size : 2 * 64);
+	size_t const pairs = _in.size() / pairSize;
+	if (pairs * pairSize != _in.size())
+		// Invalid length.
+		return false;
+
+	o_g1s.resize(pairs);
+	o_g2s.resize(pairs);
+	for (size_t i = 0; i < pairs; ++i)
+	{
+		bytesConstRef const pair = _in.cropped(i * pairSize, pairSize);
+		if (!decodePair(pair.cropped(0, g1Size), pair.cropped(g1Size), _encoding, o_g1s[i], o_g2s[i]))
+			return false;
+	}
+	for (auto const& p: o_g2s)
+		if (!isInG2Subgroup(p))
+			// p is not an element of the group (has wrong order)
+			return false;
+
+	size_t kept = 0;
+	for (size_t i = 0; i < pairs; ++i)
+		if (!o_g1s[i].isZero() && !o_g2s[i].isZero())
+		{
+			o_g1s[kept] = o_g1s[i];
+			o_g2s[kept] = o_g2s[i];
+			++kept;
+		}
+	o_g1s.resize(kept);
+	o_g2s.resize(kept);
+	return true;
+}
+
+vector<G2Prepared> prepareAll(vector<G2> const& _g2s)
+{
+	vector<G2Prepared> prepared;
+	prepared.reserve(_g2s.size());
+	for (auto const& p: _g2s)
+		prepared.push_back(prepareG2(p));
+	return prepared;
+}
+
+/// Largest number of prepared G2 points, of about 17 kB each, that a thread
+/// keeps between pairing checks.
+size_t constexpr c_maxPooledPreparedG2 = 64;
+
+/// Buffers of the pairing checks of a thread. They are reused by every check,
+/// so a check of up to c_maxPooledPreparedG2 pairs does not allocate once the
+/// buffers have grown to its size.
+struct PairingScratch
+{
+	vector<G1> g1s;
+	vector<G2> g2s;
+	/// Never shrunk below c_maxPooledPreparedG2 so that the line vectors of
+	/// its elements stay allocated.
+	vector<G2Prepared> prepared;
+};
+
+PairingScratch& pairingScratch()
+{
+	thread_local PairingScratch s_scratch;
+	return s_scratch;
+}
+
+/// @returns false for invalid input, otherwise sets @a o_one to whether the
+/// product of the pairings is one.
+bool pairingCheck(dev::bytesConstRef _in, AltBn128Encoding _encoding, bool& o_one)
+{
+	PairingScratch& scratch = pairingScratch();
+	if (!decodePairs(_in, _encoding, scratch.g1s, scratch.g2s))
+		return false;
+
+	size_t const count = scratch.g1s.size();
+	if (scratch.prepared.size() < count)
+		scratch.prepared.resize(count);
+	for (size_t i = 0; i < count; ++i)
+		prepareG2(scratch.g2s[i], scratch.prepared[i]);
+	// All Miller loops share the squarings of a single accumulator.
+	Fq12 const x = multiMillerLoop(scratch.g1s.data(), scratch.prepared.data(), count);
+	if (scratch.prepared.size() > c_maxPooledPreparedG2)
+		scratch.prepared.resize(c_maxPooledPreparedG2);
+
+	o_one = finalExponentiation(x).isOne();
+	return true;
+}
+
+pair<bool, bytes> pairingProduct(dev::bytesConstRef _in, AltBn128Encoding _encoding)
+{
+	// Output: 1 if pairing evaluates to 1, 0 otherwise (left-padded to 32 bytes)
+	bool one;
+	if (!pairingCheck(_in, _encoding, one))
 		// Signal the call failure for invalid input.
 		return {false, bytes{}};
+	return {true, h256{one}.asBytes()};
+}
+
+/// A pairing check of a batch, with its G1 points multiplied by a random weight.
+struct WeightedCheck
+{
+	size_t index;
+	vector<G1> g1s;
+	vector<G2Prepared> g2s;
+};
+
+/// @returns true if the product of all pairings of the checks [_begin, _end) is one.
+bool isProductOne(vector<WeightedCheck> const& _checks, size_t _begin, size_t _end)
+{
+	vector<G1> g1s;
+	vector<G2Prepared const*> g2s;
+	for (size_t i = _begin; i < _end; ++i)
+		for (size_t j = 0; j < _checks[i].g1s.size(); ++j)
+		{
+			g1s.push_back(_checks[i].g1s[j]);
+			g2s.push_back(&_checks[i].g2s[j]);
+		}
+	return finalExponentiation(multiMillerLoop(g1s.data(), g2s.data(), g1s.size())).isOne();
+}
+
+/// Finds the failing checks of [_begin, _end) by bisection and writes all results.
+/// @a _knownFailing is set if the product of the range is already known not to be one.
+void settleChecks(
+	vector<WeightedCheck> const& _checks,
+	size_t _begin,
+	size_t _end,
+	bool _knownFailing,
+	vector<pair<bool, bytes>>& io_results
+)
+{
+	if (!_knownFailing && isProductOne(_checks, _begin, _end))
+	{
+		for (size_t i = _begin; i < _end; ++i)
+			io_results[_checks[i].index] = {true, h256{1}.asBytes()};
+		return;
+	}
+	if (_end - _begin == 1)
+	{
+		io_results[_checks[_begin].index] = {true, h256{0}.asBytes()};
+		return;
+	}
+	size_t const mid = _begin + (_end - _begin) / 2;
+	if (isProductOne(_checks, _begin, mid))
+	{
+		for (size_t i = _begin; i < mid; ++i)
+			io_results[_checks[i].index] = {true, h256{1}.asBytes()};
+		// The failure must be in the other half.
+		settleChecks(_checks, mid, _end, true, io_results);
+	}
+	else
+	{
+		settleChecks(_checks, _begin, mid, true, io_results);
+		settleChecks(_checks, mid, _end, false, io_results);
 	}
 }
 
-pair<bool, bytes> dev::crypto::alt_bn128_G1_add(dev::bytesConstRef _in)
+/// Bounded LRU map from the Keccak-256 hash of a pairing input to its result.
+class PairingCache
 {
-	try
+public:
+	bool lookup(h256 const& _key, pair<bool, bytes>& o_result)
 	{
-		initLibSnark();
-		libff::alt_bn128_G1 const p1 = decodePointG1(_in);
-		libff::alt_bn128_G1 const p2 = decodePointG1(_in.cropped(32 * 2));
-		return {true, encodePointG1(p1 + p2)};
+		Guard l(x_cache);
+		auto it = m_index.find(_key);
+		if (it == m_index.end())
+		{
+			++m_misses;
+			return false;
+		}
+		++m_hits;
+		m_entries.splice(m_entries.begin(), m_entries, it->second);
+		o_result = it->second->second;
+		return true;
 	}
-	catch (InvalidEncoding const&)
+
+	void insert(h256 const& _key, pair<bool, bytes> const& _result)
+	{
+		Guard l(x_cache);
+		if (!m_capacity || m_index.count(_key))
+			return;
+		m_entries.emplace_front(_key, _result);
+		m_index[_key] = m_entries.begin();
+		evict();
+	}
+
+	void setCapacity(size_t _entries)
+	{
+		Guard l(x_cache);
+		m_capacity = _entries;
+		evict();
+	}
+
+	size_t capacity() const
 	{
+		Guard l(x_cache);
+		return m_capacity;
+	}
+
+	AltBn128PairingCacheStats stats() const
+	{
+		Guard l(x_cache);
+		return {m_hits, m_misses, m_evictions, m_entries.size(), m_capacity};
+	}
+
+private:
+	void evict()
+	{
+		while (m_entries.size() > m_capacity)
+		{
+			m_index.erase(m_entries.back().first);
+			m_entries.pop_back();
+			++m_evictions;
+		}
+	}
+
+	using Entries = list<pair<h256, pair<bool, bytes>>>;
+
+	mutable Mutex x_cache;
+	size_t m_capacity = 0;
+	Entries m_entries;
+	unordered_map<h256, Entries::iterator> m_index;
+	uint64_t m_hits = 0;
+	uint64_t m_misses = 0;
+	uint64_t m_evictions = 0;
+};
+
+PairingCache& pairingCache()
+{
+	static PairingCache s_cache;
+	return s_cache;
+}
+
+G1 decodeFixedBaseG1(dev::bytesConstRef _point)
+{
+	G1 p;
+	if (_point.size() > 64 || !decodePointG1(_point, p))
+		BOOST_THROW_EXCEPTION(InvalidPointEncoding());
+	return p;
+}
+
+G2 decodeFixedBaseG2(dev::bytesConstRef _point)
+{
+	G2 p;
+	if (_point.size() > 128 || !decodePointG2(_point, p))
+		BOOST_THROW_EXCEPTION(InvalidPointEncoding());
+	return p;
+}
+
+/// A fixed-base table that is either owned or one of the shared generator
+/// tables.
+template <class Point>
+class FixedBase
+{
+public:
+	explicit FixedBase(Point const& _base): m_owned(_base, 256, c_fixedBaseWindowBits), m_table(&m_owned) {}
+	explicit FixedBase(FixedBaseTable<Point> const& _shared): m_table(&_shared) {}
+
+	Point mul(dev::bytesConstRef _scalar) const { return m_table->mul(decodeScalar(_scalar)); }
+
+private:
+	FixedBaseTable<Point> m_owned;
+	FixedBaseTable<Point> const* m_table;
+};
+
+}
+
+pair<bool, bytes> dev::crypto::alt_bn128_pairing_product(dev::bytesConstRef _in, AltBn128Encoding _encoding)
+{
+	PairingCache& cache = pairingCache();
+	if (_encoding != AltBn128Encoding::Uncompressed || !cache.capacity())
+		return pairingProduct(_in, _encoding);
+
+	h256 const key = sha3(_in);
+	pair<bool, bytes> result;
+	if (cache.lookup(key, result))
+		return result;
+	result = pairingProduct(_in, _encoding);
+	cache.insert(key, result);
+	return result;
+}
+
+bool dev::crypto::alt_bn128_pairing_product(dev::bytesConstRef _in, dev::bytesRef o_out)
+{
+	assert(o_out.size() >= 32);
+	if (pairingCache().capacity())
+	{
+		auto const result = alt_bn128_pairing_product(_in);
+		if (result.first)
+			copy(result.second.begin(), result.second.end(), o_out.begin());
+		return result.first;
+	}
+
+	bool one;
+	if (!pairingCheck(_in, AltBn128Encoding::Uncompressed, one))
+		return false;
+	h256{one}.ref().copyTo(o_out);
+	return true;
+}
+
+void dev::crypto::setAltBn128PairingCacheCapacity(size_t _entries)
+{
+	pairingCache().setCapacity(_entries);
+}
+
+AltBn128PairingCacheStats dev::crypto::altBn128PairingCacheStats()
+{
+	return pairingCache().stats();
+}
+
+void dev::crypto::setAltBn128G1MulCacheLimit(size_t _memoryBytes, unsigned _threshold)
+{
+	g1MulCache().setLimit(_memoryBytes, _threshold);
+}
+
+AltBn128G1MulCacheStats dev::crypto::altBn128G1MulCacheStats()
+{
+	return g1MulCache().stats();
+}
+
+vector<pair<bool, bytes>> dev::crypto::alt_bn128_pairing_product_batch(vector<bytesConstRef> const& _inputs)
+{
+	vector<pair<bool, bytes>> results(_inputs.size());
+
+	// Weighting check i by a random r_i turns prod_i e_i == 1 into
+	// prod_i e_i^r_i == 1, which a failing check only passes with probability
+	// about 2^-127. All checks then share one Miller loop and one final
+	// exponentiation.
+	vector<WeightedCheck> checks;
+	checks.reserve(_inputs.size());
+	for (size_t i = 0; i < _inputs.size(); ++i)
+	{
+		WeightedCheck check{i, {}, {}};
+		vector<G2> g2s;
+		if (!decodePairs(_inputs[i], AltBn128Encoding::Uncompressed, check.g1s, g2s))
+		{
+			// Signal the call failure for invalid input.
+			results[i] = {false, bytes{}};
+			continue;
+		}
+		check.g2s = prepareAll(g2s);
+		h128 const random = h128::random();
+		BigInt<2> weight;
+		weight.fromBigEndian(random.data(), random.size);
+		weight.data[0] |= 1;
+		for (auto& g1: check.g1s)
+			g1 = g1.mul(weight);
+		G1::batchToAffine(check.g1s);
+		checks.push_back(move(check));
+	}
+
+	if (!checks.empty())
+		settleChecks(checks, 0, checks.size(), false, results);
+	return results;
+}
+
+pair<bool, bytes> dev::crypto::alt_bn128_G1_add(dev::bytesConstRef _in)
+{
+	G1 r;
+	if (!computeG1Add(_in, r))
 		// Signal the call failure for invalid input.
 		return {false, bytes{}};
-	}
+	return {true, encodePointG1(r)};
+}
+
+bool dev::crypto::alt_bn128_G1_add(dev::bytesConstRef _in, dev::bytesRef o_out)
+{
+	assert(o_out.size() >= 64);
+	G1 r;
+	if (!computeG1Add(_in, r))
+		return false;
+	encodePointG1(r, o_out.data());
+	return true;
 }
 
 pair<bool, bytes> dev::crypto::alt_bn128_G1_mul(dev::bytesConstRef _in)
 {
-	try
+	G1 r;
+	if (!computeG1Mul(_in, r))
+		// Signal the call failure for invalid input.
+		return {false, bytes{}};
+	return {true, encodePointG1(r)};
+}
+
+bool dev::crypto::alt_bn128_G1_mul(dev::bytesConstRef _in, dev::bytesRef o_out)
+{
+	assert(o_out.size() >= 64);
+	G1 r;
+	if (!computeG1Mul(_in, r))
+		return false;
+	encodePointG1(r, o_out.data());
+	return true;
+}
+
+vector<pair<bool, bytes>> dev::crypto::alt_bn128_G1_batch(vector<AltBn128G1Call> const& _calls)
+{
+	vector<pair<bool, bytes>> results(_calls.size());
+
+	// Results stay in Jacobian form until all calls are done so that the
+	// conversion to affine coordinates shares a single field inversion.
+	vector<G1> points;
+	vector<size_t> owners;
+	points.reserve(_calls.size());
+	owners.reserve(_calls.size());
+	for (size_t i = 0; i < _calls.size(); ++i)
 	{
-		initLibSnark();
-		libff::alt_bn128_G1 const p = decodePointG1(_in.cropped(0));
-		libff::alt_bn128_G1 const result = toLibsnarkBigint(h256(_in.cropped(64), h256::AlignLeft)) * p;
-		return {true, encodePointG1(result)};
+		G1 p;
+		bool const ok = _calls[i].op == AltBn128G1Op::Add ?
+			computeG1Add(_calls[i].input, p) :
+			computeG1Mul(_calls[i].input, p);
+		if (!ok)
+			// Signal the call failure for invalid input.
+			results[i] = {false, bytes{}};
+		else if (p.isZero())
+			results[i] = {true, bytes(64, 0)};
+		else
+		{
+			results[i].first = true;
+			points.push_back(p);
+			owners.push_back(i);
+		}
 	}
-	catch (InvalidEncoding const&)
+
+	G1::batchToAffine(points);
+	for (size_t j = 0; j < points.size(); ++j)
+		results[owners[j]].second = encodeAffinePointG1(points[j]);
+	return results;
+}
+
+pair<bool, bytes> dev::crypto::alt_bn128_G1_msm(dev::bytesConstRef _in, AltBn128Encoding _encoding)
+{
+	// Input: list of pairs of G1 point (64 or 32 bytes) and scalar (32 bytes)
+	// Output: the G1 point sum of all scalar multiplications
+
+	bool const compressed = _encoding == AltBn128Encoding::Compressed;
+	size_t const pointSize = compressed ? c_compressedG1Size : 2 * 32;
+	size_t const termSize = pointSize + 32;
+	size_t const terms = _in.size() / termSize;
+	if (terms * termSize != _in.size())
+		// Invalid length.
+		return {false, bytes{}};
+
+	vector<G1> points;
+	vector<Scalar> scalars;
+	points.reserve(terms);
+	scalars.reserve(terms);
+	for (size_t i = 0; i < terms; ++i)
 	{
+		bytesConstRef const term = _in.cropped(i * termSize, termSize);
+		G1 p;
+		if (!(compressed ? decompressPointG1(term, p) : decodePointG1(term, p)))
+			// Signal the call failure for invalid input.
+			return {false, bytes{}};
+		Scalar const s = decodeScalar(term.cropped(pointSize));
+		if (p.isZero() || s.isZero())
+			continue;
+		points.push_back(p);
+		scalars.push_back(s);
+	}
+
+	return {true, encodePointG1(multiScalarMul(move(points), scalars))};
+}
+
+pair<bool, bytes> dev::crypto::alt_bn128_G2_add(dev::bytesConstRef _in)
+{
+	G2 r;
+	if (!computeG2Add(_in, r))
 		// Signal the call failure for invalid input.
 		return {false, bytes{}};
+	return {true, encodePointG2(r)};
+}
+
+pair<bool, bytes> dev::crypto::alt_bn128_G2_mul(dev::bytesConstRef _in)
+{
+	G2 r;
+	if (!computeG2Mul(_in, r))
+		// Signal the call failure for invalid input.
+		return {false, bytes{}};
+	return {true, encodePointG2(r)};
+}
+
+pair<bool, bytes> dev::crypto::alt_bn128_G2_msm(dev::bytesConstRef _in, AltBn128Encoding _encoding)
+{
+	// Input: list of pairs of G2 point (128 or 64 bytes) and scalar (32 bytes)
+	// Output: the G2 point sum of all scalar multiplications
+
+	bool const compressed = _encoding == AltBn128Encoding::Compressed;
+	size_t const pointSize = compressed ? c_compressedG2Size : 4 * 32;
+	size_t const termSize = pointSize + 32;
+	size_t const terms = _in.size() / termSize;
+	if (terms * termSize != _in.size())
+		// Invalid length.
+		return {false, bytes{}};
+
+	vector<G2> points;
+	vector<Scalar> scalars;
+	points.reserve(terms);
+	scalars.reserve(terms);
+	for (size_t i = 0; i < terms; ++i)
+	{
+		bytesConstRef const term = _in.cropped(i * termSize, termSize);
+		G2 p;
+		if (!(compressed ? decompressPointG2(term, p) : decodePointG2(term, p)))
+			// Signal the call failure for invalid input.
+			return {false, bytes{}};
+		Scalar const s = decodeScalar(term.cropped(pointSize));
+		if (p.isZero() || s.isZero())
+			continue;
+		points.push_back(p);
+		scalars.push_back(s);
+	}
+
+	return {true, encodePointG2(multiScalarMul(move(points), scalars))};
+}
+
+pair<bool, bytes> dev::crypto::alt_bn128_G1_compress(dev::bytesConstRef _in)
+{
+	G1 p;
+	if (_in.size() != 64 || !decodePointG1(_in, p))
+		return {false, bytes{}};
+	return {true, compressPointG1(p)};
+}
+
+pair<bool, bytes> dev::crypto::alt_bn128_G1_decompress(dev::bytesConstRef _in)
+{
+	G1 p;
+	if (_in.size() != c_compressedG1Size || !decompressPointG1(_in, p))
+		return {false, bytes{}};
+	return {true, encodePointG1(p)};
+}
+
+pair<bool, bytes> dev::crypto::alt_bn128_G2_compress(dev::bytesConstRef _in)
+{
+	G2 p;
+	if (_in.size() != 128 || !decodePointG2(_in, p))
+		return {false, bytes{}};
+	return {true, compressPointG2(p)};
+}
+
+pair<bool, bytes> dev::crypto::alt_bn128_G2_decompress(dev::bytesConstRef _in)
+{
+	G2 p;
+	if (_in.size() != c_compressedG2Size || !decompressPointG2(_in, p))
+		return {false, bytes{}};
+	return {true, encodePointG2(p)};
+}
+
+pair<bool, bytes> dev::crypto::alt_bn128_G1_decompress_batch(dev::bytesConstRef _in)
+{
+	return decompressBatch<G1>(_in, c_compressedG1Size, decompressPointG1, encodePointG1);
+}
+
+pair<bool, bytes> dev::crypto::alt_bn128_G2_decompress_batch(dev::bytesConstRef _in)
+{
+	return decompressBatch<G2>(_in, c_compressedG2Size, decompressPointG2, encodePointG2);
+}
+
+bytes dev::crypto::alt_bn128_hash_to_G1(dev::bytesConstRef _message, dev::bytesConstRef _dst)
+{
+	return encodePointG1(hashToG1(_message, _dst));
+}
+
+bytes dev::crypto::alt_bn128_hash_to_G1_batch(vector<dev::bytesConstRef> const& _messages, dev::bytesConstRef _dst)
+{
+	vector<G1> points = hashToG1(_messages, _dst);
+	// The sum of the two mapped points is zero only for a negligible share of
+	// messages, but batchToAffine needs non-zero points.
+	vector<G1> nonZero;
+	vector<size_t> owners;
+	nonZero.reserve(points.size());
+	owners.reserve(points.size());
+	for (size_t i = 0; i < points.size(); ++i)
+		if (!points[i].isZero())
+		{
+			nonZero.push_back(points[i]);
+			owners.push_back(i);
+		}
+	G1::batchToAffine(nonZero);
+
+	bytes out(64 * points.size(), 0);
+	for (size_t j = 0; j < nonZero.size(); ++j)
+	{
+		bytes const encoded = encodeAffinePointG1(nonZero[j]);
+		copy(encoded.begin(), encoded.end(), out.begin() + 64 * owners[j]);
+	}
+	return out;
+}
+
+class dev::crypto::AltBn128G1FixedBase::Impl: public FixedBase<G1>
+{
+public:
+	using FixedBase<G1>::FixedBase;
+};
+
+AltBn128G1FixedBase::AltBn128G1FixedBase(bytesConstRef _point):
+	m_impl(new Impl(decodeFixedBaseG1(_point)))
+{}
+
+AltBn128G1FixedBase::AltBn128G1FixedBase(unique_ptr<Impl> _impl): m_impl(move(_impl)) {}
+
+AltBn128G1FixedBase::~AltBn128G1FixedBase() = default;
+
+AltBn128G1FixedBase const& AltBn128G1FixedBase::generator()
+{
+	static AltBn128G1FixedBase const s_generator(unique_ptr<Impl>(new Impl(g1GeneratorTable())));
+	return s_generator;
+}
+
+bytes AltBn128G1FixedBase::mul(bytesConstRef _scalar) const
+{
+	return encodePointG1(m_impl->mul(_scalar));
+}
+
+class dev::crypto::AltBn128G2FixedBase::Impl: public FixedBase<G2>
+{
+public:
+	using FixedBase<G2>::FixedBase;
+};
+
+AltBn128G2FixedBase::AltBn128G2FixedBase(bytesConstRef _point):
+	m_impl(new Impl(decodeFixedBaseG2(_point)))
+{}
+
+AltBn128G2FixedBase::AltBn128G2FixedBase(unique_ptr<Impl> _impl): m_impl(move(_impl)) {}
+
+AltBn128G2FixedBase::~AltBn128G2FixedBase() = default;
+
+AltBn128G2FixedBase const& AltBn128G2FixedBase::generator()
+{
+	static AltBn128G2FixedBase const s_generator(unique_ptr<Impl>(new Impl(g2GeneratorTable())));
+	return s_generator;
+}
+
+bytes AltBn128G2FixedBase::mul(bytesConstRef _scalar) const
+{
+	return encodePointG2(m_impl->mul(_scalar));
+}
+
+class dev::crypto::AltBn128PairingAccumulator::Impl
+{
+public:
+	explicit Impl(AltBn128Encoding _encoding): m_encoding(_encoding) {}
+
+	bool add(bytesConstRef _g1, bytesConstRef _g2)
+	{
+		bool const compressed = m_encoding == AltBn128Encoding::Compressed;
+		if (_g1.size() != (compressed ? c_compressedG1Size : 2 * 32) ||
+			_g2.size() != (compressed ? c_compressedG2Size : 2 * 64))
+			return false;
+		G1 g1;
+		G2 g2;
+		if (!decodePair(_g1, _g2, m_encoding, g1, g2) || !isInG2Subgroup(g2))
+			return false;
+		if (g1.isZero() || g2.isZero())
+			// The pairing is one.
+			return true;
+		prepareG2(g2, m_prepared);
+		m_product *= multiMillerLoop(&g1, &m_prepared, 1);
+		return true;
 	}
+
+	bool isOne() const { return finalExponentiation(m_product).isOne(); }
+
+	void reset() { m_product = Fq12::one(); }
+
+private:
+	AltBn128Encoding m_encoding;
+	/// Product of the Miller loops of all pairs added so far.
+	Fq12 m_product = Fq12::one();
+	/// Line storage reused by every pair.
+	G2Prepared m_prepared;
+};
+
+AltBn128PairingAccumulator::AltBn128PairingAccumulator(AltBn128Encoding _encoding):
+	m_impl(new Impl(_encoding))
+{}
+
+AltBn128PairingAccumulator::~AltBn128PairingAccumulator() = default;
+
+bool AltBn128PairingAccumulator::add(bytesConstRef _g1, bytesConstRef _g2)
+{
+	return m_impl->add(_g1, _g2);
+}
+
+bytes AltBn128PairingAccumulator::finalize()
+{
+	bool const result = m_impl->isOne();
+	m_impl->reset();
+	return h256{result}.asBytes();
 }
@@ -22,14 +22,236 @@
 
 #include <libdevcore/Common.h>
 
+#include <memory>
+
 namespace dev
 {
 namespace crypto
 {
 
-std::pair<bool, bytes> alt_bn128_pairing_product(bytesConstRef _in);
+enum class AltBn128G1Op
+{
+	Add,
+	Mul
+};
+
+/// A single alt_bn128_G1_add or alt_bn128_G1_mul call of a batch.
+struct AltBn128G1Call
+{
+	AltBn128G1Op op;
+	bytesConstRef input;
+};
+
+/// Point encodings accepted by the pairing and MSM functions.
+///
+/// Uncompressed points are x | y, 32 byte big-endian numbers each, with G2
+/// coordinates written as c1 | c0; zero encodes the point at infinity.
+/// Compressed points are x alone (32 bytes for G1, 64 for G2). The two most
+/// significant bits of the first byte hold the flags: 0x80 marks y as the
+/// larger of y and -y (Fq2 elements compare by c1 first), 0x40 marks the point
+/// at infinity, whose remaining bits must be zero.
+enum class AltBn128Encoding
+{
+	Uncompressed,
+	Compressed
+};
+
+/// Counters of the alt_bn128_pairing_product result cache.
+struct AltBn128PairingCacheStats
+{
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t evictions;
+	size_t size;
+	size_t capacity;
+};
+
+std::pair<bool, bytes> alt_bn128_pairing_product(
+	bytesConstRef _in,
+	AltBn128Encoding _encoding = AltBn128Encoding::Uncompressed
+);
+
+/// Bounds the number of memoized alt_bn128_pairing_product results, keyed by the
+/// Keccak-256 hash of the input. 0, the default, disables the cache and drops all
+/// entries; keep it that way on consensus-critical paths. Only uncompressed
+/// inputs are cached.
+void setAltBn128PairingCacheCapacity(size_t _entries);
+AltBn128PairingCacheStats altBn128PairingCacheStats();
+
+/// Evaluates many independent pairing checks with a single final exponentiation,
+/// combining them with random weights and bisecting to locate failing checks.
+/// @returns for every input what alt_bn128_pairing_product returns; a failing
+/// check is only reported as passing with probability about 2^-127.
+std::vector<std::pair<bool, bytes>> alt_bn128_pairing_product_batch(std::vector<bytesConstRef> const& _inputs);
+
 std::pair<bool, bytes> alt_bn128_G1_add(bytesConstRef _in);
 std::pair<bool, bytes> alt_bn128_G1_mul(bytesConstRef _in);
 
+/// The three EVM precompiles writing their result to @a o_out, which must
+/// hold 64 bytes for the G1 operations and 32 for the pairing check, instead
+/// of allocating it. @returns false for invalid input.
+bool alt_bn128_G1_add(bytesConstRef _in, bytesRef o_out);
+bool alt_bn128_G1_mul(bytesConstRef _in, bytesRef o_out);
+bool alt_bn128_pairing_product(bytesConstRef _in, bytesRef o_out);
+
+/// Counters of the alt_bn128_G1_mul base cache.
+struct AltBn128G1MulCacheStats
+{
+	/// Multiplications done with a cached table.
+	uint64_t hits;
+	uint64_t builds;
+	uint64_t evictions;
+	/// Bases with a table and bases whose uses are still being counted.
+	size_t tables;
+	size_t tracked;
+	size_t memory;
+	size_t memoryLimit;
+};
+
+/// Uses of a base before alt_bn128_G1_mul builds its table: a table costs
+/// about 20 plain multiplications and saves about half of each later one, so
+/// it pays off after about 40 uses.
+unsigned constexpr c_altBn128G1MulCacheThreshold = 32;
+
+/// Lets alt_bn128_G1_mul and alt_bn128_G1_batch count the uses of their base
+/// points and, once a base has been used more than @a _threshold times, keep
+/// a fixed-base table of it (about 250 KiB) for later multiplications.
+/// Tables and counters are evicted least recently used first to stay within
+/// @a _memoryBytes. 0, the default, disables the cache and drops all entries.
+/// A limit below the size of one table only counts uses and builds no tables.
+void setAltBn128G1MulCacheLimit(size_t _memoryBytes, unsigned _threshold = c_altBn128G1MulCacheThreshold);
+AltBn128G1MulCacheStats altBn128G1MulCacheStats();
+
+/// Multi-scalar multiplication over G1.
+/// Input: k concatenated (G1 point, 32 byte big-endian scalar) pairs.
+/// Output: the uncompressed G1 point sum_i scalar_i * point_i.
+std::pair<bool, bytes> alt_bn128_G1_msm(
+	bytesConstRef _in,
+	AltBn128Encoding _encoding = AltBn128Encoding::Uncompressed
+);
+
+/// Executes many independent G1 add/mul calls at once.
+/// @returns for every call exactly what the corresponding single call returns.
+std::vector<std::pair<bool, bytes>> alt_bn128_G1_batch(std::vector<AltBn128G1Call> const& _calls);
+
+
+/// Addition of two G2 points, encoded like in alt_bn128_pairing_product.
+/// Input: two 128 byte points. Output: the 128 byte sum.
+/// The points must lie on the twist but, unlike in the pairing, need not be
+/// in G2.
+std::pair<bool, bytes> alt_bn128_G2_add(bytesConstRef _in);
+
+/// Scalar multiplication of a G2 point.
+/// Input: a 128 byte point and a 32 byte big-endian scalar.
+/// Points of G2 use the psi endomorphism, which roughly halves the cost.
+std::pair<bool, bytes> alt_bn128_G2_mul(bytesConstRef _in);
+
+/// Multi-scalar multiplication over G2.
+/// Input: k concatenated (G2 point, 32 byte big-endian scalar) pairs.
+/// Output: the uncompressed G2 point sum_i scalar_i * point_i.
+std::pair<bool, bytes> alt_bn128_G2_msm(
+	bytesConstRef _in,
+	AltBn128Encoding _encoding = AltBn128Encoding::Uncompressed
+);
+
+/// Conversions between the uncompressed and compressed point encodings.
+/// Decompression checks that the point lies on the curve but, like decoding,
+/// leaves the G2 subgroup check to the pairing.
+std::pair<bool, bytes> alt_bn128_G1_compress(bytesConstRef _in);
+std::pair<bool, bytes> alt_bn128_G1_decompress(bytesConstRef _in);
+std::pair<bool, bytes> alt_bn128_G2_compress(bytesConstRef _in);
+std::pair<bool, bytes> alt_bn128_G2_decompress(bytesConstRef _in);
+
+/// Decompresses k concatenated compressed points into k uncompressed ones.
+/// Fails if any of the points is invalid.
+std::pair<bool, bytes> alt_bn128_G1_decompress_batch(bytesConstRef _in);
+std::pair<bool, bytes> alt_bn128_G2_decompress_batch(bytesConstRef _in);
+
+/// Hash-to-curve of RFC 9380 for G1 with the suite
+/// BN254G1_XMD:SHA-256_SVDW_RO_ under the domain separation tag @a _dst.
+/// @returns the uncompressed 64 byte point, which is never invalid.
+bytes alt_bn128_hash_to_G1(bytesConstRef _message, bytesConstRef _dst);
+
+/// Hashes k messages under one tag into k concatenated uncompressed points,
+/// sharing the field inversions between them.
+bytes alt_bn128_hash_to_G1_batch(std::vector<bytesConstRef> const& _messages, bytesConstRef _dst);
+
+
+/// Precomputed multiples of a fixed G1 point for multiplying it by many
+/// scalars. A multiplication costs about 43 mixed additions, several times
+/// faster than the doublings and additions of alt_bn128_G1_mul.
+class AltBn128G1FixedBase
+{
+public:
+	/// Builds the table of @a _point, encoded as in alt_bn128_G1_mul.
+	/// Throws InvalidPointEncoding if it is not a point of the curve.
+	explicit AltBn128G1FixedBase(bytesConstRef _point);
+	~AltBn128G1FixedBase();
+
+	/// The table of the generator (1, 2), built on first use.
+	static AltBn128G1FixedBase const& generator();
+
+	/// @returns the encoding of _scalar * P. The 32 byte big-endian scalar is
+	/// padded with zeros if shorter, like in alt_bn128_G1_mul.
+	bytes mul(bytesConstRef _scalar) const;
+
+private:
+	class Impl;
+
+	explicit AltBn128G1FixedBase(std::unique_ptr<Impl> _impl);
+
+	std::unique_ptr<Impl> m_impl;
+};
+
+/// Precomputed multiples of a fixed G2 point, see AltBn128G1FixedBase.
+class AltBn128G2FixedBase
+{
+public:
+	/// Builds the table of @a _point, encoded as in alt_bn128_pairing_product.
+	/// Throws InvalidPointEncoding if it is not a point of the twist.
+	explicit AltBn128G2FixedBase(bytesConstRef _point);
+	~AltBn128G2FixedBase();
+
+	/// The table of the EIP-197 generator, built on first use.
+	static AltBn128G2FixedBase const& generator();
+
+	/// @returns the 128 byte encoding of _scalar * Q.
+	bytes mul(bytesConstRef _scalar) const;
+
+private:
+	class Impl;
+
+	explicit AltBn128G2FixedBase(std::unique_ptr<Impl> _impl);
+
+	std::unique_ptr<Impl> m_impl;
+};
+
+/// A pairing check like alt_bn128_pairing_product over pairs that arrive one
+/// at a time, e.g. from the network. Every pair is decoded, validated and run
+/// through its Miller loop as it is added, which leaves only the final
+/// exponentiation to finalize.
+class AltBn128PairingAccumulator
+{
+public:
+	explicit AltBn128PairingAccumulator(AltBn128Encoding _encoding = AltBn128Encoding::Uncompressed);
+	~AltBn128PairingAccumulator();
+
+	/// Adds the pair (_g1, _g2), each point encoded as in
+	/// alt_bn128_pairing_product.
+	/// @returns false, leaving the accumulator unchanged, if either point is
+	/// invalid or the G2 point is not in G2.
+	bool add(bytesConstRef _g1, bytesConstRef _g2);
+
+	/// @returns 1 if the product of the pairings of all pairs added since the
+	/// last call is one, 0 otherwise (left-padded to 32 bytes), and starts
+	/// over with no pairs.
+	bytes finalize();
+
+private:
+	class Impl;
+
+	std::unique_ptr<Impl> m_impl;
+};
+
 }
 }
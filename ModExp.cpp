@@ -0,0 +1,647 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2014-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+
+#include <libdevcrypto/ModExp.h>
+#include <libdevcrypto/Montgomery.h>
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <vector>
+
+using namespace std;
+using namespace dev;
+using namespace dev::crypto;
+
+namespace
+{
+
+using bigint::uint128;
+
+/// Moduli up to this many limbs (4096 bits) keep all residues on the stack.
+/// Those of exactly 1, 2, 4, 8, 16, 32 or 64 limbs get kernels of fixed
+/// width.
+size_t constexpr c_maxFixedLimbs = 64;
+
+uint64_t const c_saturated = numeric_limits<uint64_t>::max();
+
+/// Reads a 32 byte big-endian length, saturating at c_saturated.
+uint64_t readLength(bytesConstRef _in, size_t _offset)
+{
+	uint64_t length = 0;
+	for (size_t i = 0; i < 32; ++i)
+	{
+		byte const b = _offset + i < _in.size() ? _in[_offset + i] : 0;
+		if (i < 24 && b)
+			return c_saturated;
+		if (i >= 24)
+			length = (length << 8) | b;
+	}
+	return length;
+}
+
+struct Lengths
+{
+	uint64_t base;
+	uint64_t exponent;
+	uint64_t modulus;
+};
+
+Lengths readLengths(bytesConstRef _in)
+{
+	return {readLength(_in, 0), readLength(_in, 32), readLength(_in, 64)};
+}
+
+/// A big-endian number of @a length bytes at @a offset of the input, which
+/// reads as zero beyond its end.
+struct Operand
+{
+	bytesConstRef in;
+	uint64_t offset;
+	uint64_t length;
+
+	/// @returns the byte @a _i counted from the most significant one.
+	byte byteAt(uint64_t _i) const
+	{
+		uint64_t const p = offset + _i;
+		return p < in.size() ? in[p] : 0;
+	}
+
+	/// @returns the 64-bit limb @a _i counted from the least significant one.
+	uint64_t limb(uint64_t _i) const
+	{
+		uint64_t r = 0;
+		for (unsigned b = 0; b < 8; ++b)
+		{
+			uint64_t const fromEnd = 8 * _i + b;
+			if (fromEnd < length)
+				r |= uint64_t(byteAt(length - 1 - fromEnd)) << (8 * b);
+		}
+		return r;
+	}
+
+	bool bit(uint64_t _i) const
+	{
+		return (byteAt(length - 1 - _i / 8) >> (_i % 8)) & 1;
+	}
+
+	uint64_t bitLength() const
+	{
+		uint64_t const present = in.size() > offset ? min<uint64_t>(length, in.size() - offset) : 0;
+		for (uint64_t i = 0; i < present; ++i)
+			if (byte const b = in[offset + i])
+				return 8 * (length - 1 - i) + 32 - __builtin_clz(b);
+		return 0;
+	}
+
+	/// @returns the bit length of the number formed by its first 32 bytes.
+	uint64_t headBitLength() const
+	{
+		return Operand{in, offset, min<uint64_t>(length, 32)}.bitLength();
+	}
+};
+
+/// N limbs on the stack, or a number given at runtime on the heap for N == 0.
+template <size_t N>
+class Limbs
+{
+public:
+	explicit Limbs(size_t) {}
+	uint64_t* data() { return m_data; }
+	uint64_t const* data() const { return m_data; }
+
+private:
+	uint64_t m_data[N];
+};
+
+template <>
+class Limbs<0>
+{
+public:
+	explicit Limbs(size_t _n): m_data(_n) {}
+	uint64_t* data() { return m_data.data(); }
+	uint64_t const* data() const { return m_data.data(); }
+
+private:
+	vector<uint64_t> m_data;
+};
+
+/// @returns the borrow of o_r = _a - _b over @a _n limbs.
+uint64_t subLimbs(uint64_t* o_r, uint64_t const* _a, uint64_t const* _b, size_t _n)
+{
+	uint64_t borrow = 0;
+	for (size_t i = 0; i < _n; ++i)
+		borrow = bigint::subBorrow(_a[i], _b[i], borrow, o_r[i]);
+	return borrow;
+}
+
+/// Residues modulo an odd number in Montgomery form with R = 2^(64 n), for n
+/// = N limbs or, if N is 0, the number of limbs given at runtime. Residues
+/// have room for Capacity limbs, on the heap if it is 0. Unlike
+/// MontgomeryField the modulus may use the top bit of its last limb, so the
+/// products keep two extra words.
+template <size_t N, size_t Capacity = N>
+class MontgomeryRing
+{
+public:
+	static size_t constexpr c_capacity = Capacity;
+
+	/// @a _m is an odd number of @a _n limbs, exactly N unless N is 0.
+	MontgomeryRing(uint64_t const* _m, size_t _n):
+		m_n(_n), m_m(_n), m_one(_n), m_r2(_n), m_t(2 * _n + 2)
+	{
+		assert((!N || _n == N) && (!Capacity || _n <= Capacity) && (_m[0] & 1));
+		copy_n(_m, _n, m_m.data());
+		m_inv = bigint::negInverse64(_m[0]);
+
+		// R mod m by doubling the top bit of m, then 2^n R by n doublings
+		// more, which six squarings take to 2^(64 n) R = R^2.
+		uint64_t* r = m_one.data();
+		fill_n(r, _n, 0);
+		size_t const top = 64 * (_n - 1) + 63 - __builtin_clzll(_m[_n - 1]);
+		r[top / 64] = uint64_t(1) << (top % 64);
+		reduce(r, 0);
+		for (size_t i = top; i < 64 * _n; ++i)
+			doubleMod(r);
+		copy_n(r, _n, m_r2.data());
+		for (size_t i = 0; i < _n; ++i)
+			doubleMod(m_r2.data());
+		for (size_t i = 0; i < 6; ++i)
+			sqr(m_r2.data(), m_r2.data());
+	}
+
+	size_t size() const { return m_n; }
+
+	void one(uint64_t* o_r) const { copy_n(m_one.data(), m_n, o_r); }
+
+	/// o_r = _a * _b / R mod m for _a < R and _b < m. o_r may alias the
+	/// arguments.
+	void mul(uint64_t* o_r, uint64_t const* _a, uint64_t const* _b) const
+	{
+		// A constant n lets the compiler unroll the fixed-width kernels.
+		size_t const n = N ? N : m_n;
+		uint64_t* t = m_t.data();
+		fill_n(t, n + 2, 0);
+		uint64_t const* m = m_m.data();
+		for (size_t i = 0; i < n; ++i)
+		{
+			uint64_t carry = 0;
+			DEV_UNROLL
+			for (size_t j = 0; j < n; ++j)
+			{
+				uint128 const s = uint128(_a[j]) * _b[i] + t[j] + carry;
+				t[j] = uint64_t(s);
+				carry = uint64_t(s >> 64);
+			}
+			uint128 s = uint128(t[n]) + carry;
+			t[n] = uint64_t(s);
+			t[n + 1] = uint64_t(s >> 64);
+
+			uint64_t const q = t[0] * m_inv;
+			s = uint128(q) * m[0] + t[0];
+			carry = uint64_t(s >> 64);
+			DEV_UNROLL
+			for (size_t j = 1; j < n; ++j)
+			{
+				s = uint128(q) * m[j] + t[j] + carry;
+				t[j - 1] = uint64_t(s);
+				carry = uint64_t(s >> 64);
+			}
+			s = uint128(t[n]) + carry;
+			t[n - 1] = uint64_t(s);
+			t[n] = t[n + 1] + uint64_t(s >> 64);
+		}
+		// t < 2m; subtract m unless that borrows from t[n].
+		if (subLimbs(o_r, t, m, n) > t[n])
+			copy_n(t, n, o_r);
+	}
+
+	/// o_r = _a^2 / R mod m: the cross products are computed once and
+	/// doubled, then the 2n-limb square is reduced, about 3/4 of the work of
+	/// mul().
+	void sqr(uint64_t* o_r, uint64_t const* _a) const
+	{
+		size_t const n = N ? N : m_n;
+		uint64_t* t = m_t.data();
+		fill_n(t, 2 * n, 0);
+		for (size_t i = 0; i + 1 < n; ++i)
+		{
+			uint64_t carry = 0;
+			DEV_UNROLL
+			for (size_t j = i + 1; j < n; ++j)
+			{
+				uint128 const s = uint128(_a[i]) * _a[j] + t[i + j] + carry;
+				t[i + j] = uint64_t(s);
+				carry = uint64_t(s >> 64);
+			}
+			t[i + n] = carry;
+		}
+		uint64_t carry = 0;
+		for (size_t i = 0; i < 2 * n; ++i)
+		{
+			uint64_t const top = t[i] >> 63;
+			t[i] = (t[i] << 1) | carry;
+			carry = top;
+		}
+		carry = 0;
+		for (size_t i = 0; i < n; ++i)
+		{
+			uint128 const s = uint128(_a[i]) * _a[i];
+			carry = bigint::addCarry(t[2 * i], uint64_t(s), carry, t[2 * i]);
+			carry = bigint::addCarry(t[2 * i + 1], uint64_t(s >> 64), carry, t[2 * i + 1]);
+		}
+
+		uint64_t const* m = m_m.data();
+		uint64_t overflow = 0;
+		for (size_t i = 0; i < n; ++i)
+		{
+			uint64_t const q = t[i] * m_inv;
+			carry = 0;
+			DEV_UNROLL
+			for (size_t j = 0; j < n; ++j)
+			{
+				uint128 const s = uint128(q) * m[j] + t[i + j] + carry;
+				t[i + j] = uint64_t(s);
+				carry = uint64_t(s >> 64);
+			}
+			uint128 const s = uint128(t[i + n]) + carry + overflow;
+			t[i + n] = uint64_t(s);
+			overflow = uint64_t(s >> 64);
+		}
+		if (subLimbs(o_r, t + n, m, n) > overflow)
+			copy_n(t + n, n, o_r);
+	}
+
+	/// o_r = _x * R mod m for any number _x.
+	void fromOperand(Operand const& _x, uint64_t* o_r) const
+	{
+		// Horner's rule over chunks of n limbs c_k, most significant first:
+		// r <- r * R + c_k * R, where both products come from multiplying by
+		// R^2.
+		size_t const n = m_n;
+		Limbs<Capacity> chunk(n);
+		fill_n(o_r, n, 0);
+		uint64_t const chunks = (_x.length + 8 * n - 1) / (8 * n);
+		for (uint64_t k = chunks; k-- > 0;)
+		{
+			for (size_t j = 0; j < n; ++j)
+				chunk.data()[j] = _x.limb(k * n + j);
+			mul(chunk.data(), chunk.data(), m_r2.data());
+			if (k + 1 < chunks)
+				mul(o_r, o_r, m_r2.data());
+			uint64_t carry = 0;
+			for (size_t j = 0; j < n; ++j)
+				carry = bigint::addCarry(o_r[j], chunk.data()[j], carry, o_r[j]);
+			reduce(o_r, carry);
+		}
+	}
+
+	/// o_r = _a / R mod m, the canonical value.
+	void toCanonical(uint64_t const* _a, uint64_t* o_r) const
+	{
+		Limbs<Capacity> unit(m_n);
+		fill_n(unit.data(), m_n, 0);
+		unit.data()[0] = 1;
+		mul(o_r, unit.data(), _a);
+	}
+
+private:
+	/// Subtracts m once from the (n + 1)-limb number @a _carry | io_r if it
+	/// is not smaller than m.
+	void reduce(uint64_t* io_r, uint64_t _carry) const
+	{
+		uint64_t* t = m_t.data();
+		if (subLimbs(t, io_r, m_m.data(), m_n) <= _carry)
+			copy_n(t, m_n, io_r);
+	}
+
+	/// io_r = 2 io_r mod m for io_r < m.
+	void doubleMod(uint64_t* io_r) const
+	{
+		uint64_t carry = 0;
+		for (size_t j = 0; j < m_n; ++j)
+		{
+			uint64_t const top = io_r[j] >> 63;
+			io_r[j] = (io_r[j] << 1) | carry;
+			carry = top;
+		}
+		reduce(io_r, carry);
+	}
+
+	size_t m_n;
+	Limbs<Capacity> m_m;
+	Limbs<Capacity> m_one;
+	Limbs<Capacity> m_r2;
+	/// Scratch space of the products.
+	mutable Limbs<Capacity ? 2 * Capacity + 2 : 0> m_t;
+	uint64_t m_inv;
+};
+
+/// Residues modulo 2^k in plain form.
+class PowerOfTwoRing
+{
+public:
+	static size_t constexpr c_capacity = 0;
+
+	explicit PowerOfTwoRing(uint64_t _k):
+		m_n((_k + 63) / 64),
+		m_mask(_k % 64 ? (uint64_t(1) << (_k % 64)) - 1 : c_saturated),
+		m_t(m_n)
+	{}
+
+	size_t size() const { return m_n; }
+
+	void one(uint64_t* o_r) const
+	{
+		fill_n(o_r, m_n, 0);
+		o_r[0] = 1;
+	}
+
+	/// The low half of the schoolbook product.
+	void mul(uint64_t* o_r, uint64_t const* _a, uint64_t const* _b) const
+	{
+		uint64_t* t = m_t.data();
+		fill_n(t, m_n, 0);
+		for (size_t i = 0; i < m_n; ++i)
+		{
+			uint64_t carry = 0;
+			for (size_t j = 0; i + j < m_n; ++j)
+			{
+				uint128 const s = uint128(_a[j]) * _b[i] + t[i + j] + carry;
+				t[i + j] = uint64_t(s);
+				carry = uint64_t(s >> 64);
+			}
+		}
+		t[m_n - 1] &= m_mask;
+		copy_n(t, m_n, o_r);
+	}
+
+	void sqr(uint64_t* o_r, uint64_t const* _a) const { mul(o_r, _a, _a); }
+
+	void fromOperand(Operand const& _x, uint64_t* o_r) const
+	{
+		for (size_t j = 0; j < m_n; ++j)
+			o_r[j] = _x.limb(j);
+		o_r[m_n - 1] &= m_mask;
+	}
+
+private:
+	size_t m_n;
+	uint64_t m_mask;
+	mutable Limbs<0> m_t;
+};
+
+/// Window width of the sliding-window exponentiation, minimising squarings
+/// plus multiplications including the table for an exponent of @a _bits.
+unsigned windowBits(uint64_t _bits)
+{
+	return _bits > 671 ? 6 : _bits > 239 ? 5 : _bits > 79 ? 4 : _bits > 23 ? 3 : 1;
+}
+
+/// o_r = _base^_exp in @a _ring, left to right with windows of odd powers.
+template <class Ring>
+void power(Ring const& _ring, uint64_t const* _base, Operand const& _exp, uint64_t* o_r)
+{
+	size_t constexpr c_tableLimbs = Ring::c_capacity * (size_t(1) << 5);
+	uint64_t const bits = _exp.bitLength();
+	if (bits == 0)
+	{
+		_ring.one(o_r);
+		return;
+	}
+
+	size_t const n = _ring.size();
+	unsigned const w = windowBits(bits);
+	size_t const entries = size_t(1) << (w - 1);
+	Limbs<c_tableLimbs> table(entries * n);
+	Limbs<Ring::c_capacity> square(n);
+	uint64_t* odd = table.data();
+	copy_n(_base, n, odd);
+	if (entries > 1)
+		_ring.sqr(square.data(), _base);
+	for (size_t i = 1; i < entries; ++i)
+		_ring.mul(odd + i * n, odd + (i - 1) * n, square.data());
+
+	bool started = false;
+	for (uint64_t i = bits; i-- > 0;)
+	{
+		if (!_exp.bit(i))
+		{
+			_ring.sqr(o_r, o_r);
+			continue;
+		}
+		// The longest window [low, i] of at most w bits that ends in a one.
+		uint64_t low = i + 1 >= w ? i + 1 - w : 0;
+		while (!_exp.bit(low))
+			++low;
+		uint64_t value = 0;
+		for (uint64_t j = i + 1; j-- > low;)
+			value = (value << 1) | uint64_t(_exp.bit(j));
+		uint64_t const* entry = odd + (value >> 1) * n;
+		if (!started)
+		{
+			copy_n(entry, n, o_r);
+			started = true;
+		}
+		else
+		{
+			for (uint64_t j = low; j <= i; ++j)
+				_ring.sqr(o_r, o_r);
+			_ring.mul(o_r, o_r, entry);
+		}
+		i = low;
+	}
+}
+
+template <size_t N, size_t Capacity>
+void powerModOdd(uint64_t const* _m, size_t _n, Operand const& _base, Operand const& _exp, uint64_t* o_r)
+{
+	MontgomeryRing<N, Capacity> const ring(_m, _n);
+	Limbs<Capacity> x(_n);
+	ring.fromOperand(_base, x.data());
+	power(ring, x.data(), _exp, o_r);
+	ring.toCanonical(o_r, o_r);
+}
+
+/// o_r = _base^_exp mod _m for an odd @a _m of @a _n limbs.
+void powerModOdd(uint64_t const* _m, size_t _n, Operand const& _base, Operand const& _exp, uint64_t* o_r)
+{
+	switch (_n)
+	{
+	case 1:
+		return powerModOdd<1, 1>(_m, _n, _base, _exp, o_r);
+	case 2:
+		return powerModOdd<2, 2>(_m, _n, _base, _exp, o_r);
+	case 4:
+		return powerModOdd<4, 4>(_m, _n, _base, _exp, o_r);
+	case 8:
+		return powerModOdd<8, 8>(_m, _n, _base, _exp, o_r);
+	case 16:
+		return powerModOdd<16, 16>(_m, _n, _base, _exp, o_r);
+	case 32:
+		return powerModOdd<32, 32>(_m, _n, _base, _exp, o_r);
+	case 64:
+		return powerModOdd<64, 64>(_m, _n, _base, _exp, o_r);
+	default:
+		if (_n <= c_maxFixedLimbs)
+			return powerModOdd<0, c_maxFixedLimbs>(_m, _n, _base, _exp, o_r);
+		return powerModOdd<0, 0>(_m, _n, _base, _exp, o_r);
+	}
+}
+
+/// o_r = _base^_exp mod _m for an even @a _m = q 2^k of @a _n limbs, from the
+/// powers modulo q and 2^k combined by the Chinese remainder theorem:
+/// x = x1 + q ((x2 - x1) q^-1 mod 2^k).
+void powerModEven(uint64_t const* _m, size_t _n, Operand const& _base, Operand const& _exp, uint64_t* o_r)
+{
+	uint64_t k = 0;
+	while (!_m[k / 64])
+		k += 64;
+	k += __builtin_ctzll(_m[k / 64]);
+
+	// q = m >> k, trimmed to its significant limbs.
+	vector<uint64_t> q(_n - k / 64);
+	for (size_t i = 0; i < q.size(); ++i)
+	{
+		uint64_t const low = _m[i + k / 64];
+		uint64_t const high = i + k / 64 + 1 < _n ? _m[i + k / 64 + 1] : 0;
+		q[i] = k % 64 ? (low >> (k % 64)) | (high << (64 - k % 64)) : low;
+	}
+	while (q.size() > 1 && !q.back())
+		q.pop_back();
+
+	vector<uint64_t> x1(q.size(), 0);
+	if (q.size() > 1 || q[0] > 1)
+		powerModOdd(q.data(), q.size(), _base, _exp, x1.data());
+
+	PowerOfTwoRing const ring(k);
+	size_t const l = ring.size();
+	vector<uint64_t> base(l);
+	vector<uint64_t> x2(l);
+	ring.fromOperand(_base, base.data());
+	power(ring, base.data(), _exp, x2.data());
+
+	// d = x2 - x1 mod 2^(64 l), then h with q h = d limb by limb.
+	vector<uint64_t> d(l);
+	vector<uint64_t> x1Low(l, 0);
+	copy_n(x1.begin(), min(l, x1.size()), x1Low.begin());
+	subLimbs(d.data(), x2.data(), x1Low.data(), l);
+	uint64_t const qInverse = 0 - bigint::negInverse64(q[0]);
+	vector<uint64_t> h(l);
+	for (size_t i = 0; i < l; ++i)
+	{
+		h[i] = d[i] * qInverse;
+		uint64_t carry = 0;
+		for (size_t j = 0; i + j < l; ++j)
+		{
+			uint64_t const qj = j < q.size() ? q[j] : 0;
+			uint128 const s = uint128(h[i]) * qj + carry;
+			uint64_t const product = uint64_t(s);
+			carry = uint64_t(s >> 64) + bigint::subBorrow(d[i + j], product, 0, d[i + j]);
+		}
+	}
+	if (k % 64)
+		h[l - 1] &= (uint64_t(1) << (k % 64)) - 1;
+
+	// x = x1 + q h < m.
+	fill_n(o_r, _n, 0);
+	copy(x1.begin(), x1.end(), o_r);
+	for (size_t i = 0; i < l; ++i)
+	{
+		uint64_t carry = 0;
+		for (size_t j = 0; j < q.size() && i + j < _n; ++j)
+		{
+			uint128 const s = uint128(h[i]) * q[j] + o_r[i + j] + carry;
+			o_r[i + j] = uint64_t(s);
+			carry = uint64_t(s >> 64);
+		}
+		for (size_t j = i + q.size(); carry && j < _n; ++j)
+			carry = bigint::addCarry(o_r[j], carry, 0, o_r[j]);
+	}
+}
+
+}
+
+pair<bool, bytes> dev::crypto::modexp(bytesConstRef _in)
+{
+	Lengths const lengths = readLengths(_in);
+	if (!lengths.modulus)
+		return {true, bytes{}};
+	if (max({lengths.base, lengths.exponent, lengths.modulus}) > c_modexpMaxLength)
+		return {false, bytes{}};
+	bytes out(lengths.modulus);
+	modexp(_in, bytesRef(&out));
+	return {true, out};
+}
+
+bool dev::crypto::modexp(bytesConstRef _in, bytesRef o_out)
+{
+	Lengths const lengths = readLengths(_in);
+	if (!lengths.modulus)
+		return true;
+	if (max({lengths.base, lengths.exponent, lengths.modulus}) > c_modexpMaxLength)
+		return false;
+	assert(o_out.size() >= lengths.modulus);
+
+	Operand const base{_in, 96, lengths.base};
+	Operand const exp{_in, 96 + lengths.base, lengths.exponent};
+	Operand const mod{_in, 96 + lengths.base + lengths.exponent, lengths.modulus};
+	byte* out = o_out.data();
+	fill_n(out, lengths.modulus, 0);
+	size_t const n = (mod.bitLength() + 63) / 64;
+	if (n == 0)
+		return true;
+
+	// The modulus and the result.
+	uint64_t stack[2 * c_maxFixedLimbs];
+	vector<uint64_t> heap;
+	uint64_t* m = stack;
+	if (n > c_maxFixedLimbs)
+	{
+		heap.resize(2 * n);
+		m = heap.data();
+	}
+	uint64_t* r = m + n;
+	for (size_t i = 0; i < n; ++i)
+		m[i] = mod.limb(i);
+
+	if (m[0] & 1)
+		powerModOdd(m, n, base, exp, r);
+	else
+		powerModEven(m, n, base, exp, r);
+
+	for (size_t i = 0; i < min<uint64_t>(8 * n, lengths.modulus); ++i)
+		out[lengths.modulus - 1 - i] = byte(r[i / 8] >> (8 * (i % 8)));
+	return true;
+}
+
+size_t dev::crypto::modexpOutputSize(bytesConstRef _in)
+{
+	return size_t(min<uint64_t>(readLengths(_in).modulus, numeric_limits<size_t>::max()));
+}
+
+uint64_t dev::crypto::modexpGas(bytesConstRef _in)
+{
+	Lengths const lengths = readLengths(_in);
+	uint64_t const longest = max(lengths.base, lengths.modulus);
+	if (longest > c_modexpMaxLength)
+		return c_saturated;
+	uint128 const words = (longest + 7) / 8;
+	uint128 const complexity = words * words;
+
+	// The exponent only counts with its first 32 bytes and its length.
+	uint128 iterations;
+	if (lengths.exponent > c_modexpMaxLength)
+		iterations = c_saturated;
+	else
+	{
+		Operand const exp{_in, 96 + lengths.base, lengths.exponent};
+		uint64_t const head = exp.headBitLength();
+		iterations = head ? head - 1 : 0;
+		if (lengths.exponent > 32)
+			iterations += 8 * uint128(lengths.exponent - 32);
+	}
+	uint128 const gas = complexity * max<uint128>(iterations, 1) / 3;
+	return uint64_t(min<uint128>(max<uint128>(gas, 200), c_saturated));
+}
@@ -0,0 +1,44 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2014-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+/** @file ModExp.h
+ * The modular exponentiation precompile of EIP-198 with the gas cost of
+ * EIP-2565.
+ *
+ * Input: the byte lengths of base, exponent and modulus as 32 byte big-endian
+ * numbers, followed by the three big-endian numbers themselves; missing input
+ * bytes are zero. Output: base^exponent mod modulus as a big-endian number of
+ * the length of the modulus, all zeros for a zero modulus.
+ */
+
+#pragma once
+
+#include <libdevcore/Common.h>
+
+namespace dev
+{
+namespace crypto
+{
+
+/// Longest base, exponent or modulus accepted, in bytes. Any input using
+/// longer ones costs far more gas than a block holds.
+uint64_t constexpr c_modexpMaxLength = 0xffffffff;
+
+/// @returns false if a length exceeds c_modexpMaxLength, except that inputs
+/// with an empty modulus always yield empty output. The caller must charge
+/// modexpGas() first: the work grows with the lengths given in the input.
+std::pair<bool, bytes> modexp(bytesConstRef _in);
+
+/// The same, writing the result to @a o_out, which must hold
+/// modexpOutputSize() bytes. Only moduli longer than 4096 bits and even ones
+/// need heap memory.
+bool modexp(bytesConstRef _in, bytesRef o_out);
+
+/// The length of the modulus, saturated to the largest size_t.
+size_t modexpOutputSize(bytesConstRef _in);
+
+/// EIP-2565 gas cost, saturated to the largest uint64_t.
+uint64_t modexpGas(bytesConstRef _in);
+
+}
+}
@@ -0,0 +1,33 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2014-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+
+#include "Montgomery.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <cpuid.h>
+#endif
+
+using namespace dev;
+using namespace dev::crypto;
+
+namespace
+{
+
+bool detectBmi2Adx()
+{
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+	unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+	if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+		return false;
+	bool const bmi2 = ebx & (1u << 8);
+	bool const adx = ebx & (1u << 19);
+	return bmi2 && adx;
+#else
+	return false;
+#endif
+}
+
+}
+
+bool dev::crypto::g_hasBmi2Adx = detectBmi2Adx();
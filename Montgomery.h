@@ -0,0 +1,590 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2014-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+/** @file Montgomery.h
+ * Fixed-width big integers and prime fields in Montgomery representation.
+ *
+ * The field is parametrised by the modulus only; everything derived from it
+ * (-p^-1 mod 2^64, R mod p, R^2 mod p, ...) is computed at compile time.
+ * Multiplication uses the "no carry" variant of CIOS which requires the most
+ * significant limb of the modulus to leave at least one bit spare. For four
+ * limb moduli a MULX/ADCX/ADOX assembly kernel is used when the CPU has BMI2
+ * and ADX.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <x86intrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+/// Fully unrolls the following fixed trip count loop.
+#define DEV_UNROLL _Pragma("GCC unroll 16")
+#else
+#define DEV_UNROLL
+#endif
+
+namespace dev
+{
+namespace crypto
+{
+
+/// Whether the CPU executing this process supports MULX, ADCX and ADOX.
+/// Set during static initialisation; until then the portable kernels are used.
+extern bool g_hasBmi2Adx;
+
+/// Unsigned integer of N 64-bit limbs, least significant limb first.
+template <size_t N>
+struct BigInt
+{
+	static constexpr size_t limbs = N;
+
+	uint64_t data[N];
+
+	constexpr bool isZero() const
+	{
+		for (size_t i = 0; i < N; ++i)
+			if (data[i])
+				return false;
+		return true;
+	}
+
+	constexpr bool testBit(size_t _i) const
+	{
+		return _i < 64 * N && ((data[_i / 64] >> (_i % 64)) & 1);
+	}
+
+	/// @returns the number of significant bits.
+	constexpr size_t numBits() const
+	{
+		for (size_t i = N; i-- > 0;)
+			if (data[i])
+			{
+				size_t bits = 64 * i;
+				for (uint64_t v = data[i]; v; v >>= 1)
+					++bits;
+				return bits;
+			}
+		return 0;
+	}
+
+	/// @returns the @a _width bit wide window starting at bit @a _offset.
+	uint64_t window(size_t _offset, unsigned _width) const
+	{
+		size_t const limb = _offset / 64;
+		size_t const shift = _offset % 64;
+		if (limb >= N)
+			return 0;
+		uint64_t d = data[limb] >> shift;
+		if (shift + _width > 64 && limb + 1 < N)
+			d |= data[limb + 1] << (64 - shift);
+		return d & ((uint64_t(1) << _width) - 1);
+	}
+
+	/// Reads a big-endian number of @a _size bytes. Excess leading bytes must be zero.
+	/// @returns false if the number does not fit.
+	bool fromBigEndian(uint8_t const* _data, size_t _size)
+	{
+		*this = BigInt{};
+		for (size_t i = 0; i < _size; ++i)
+		{
+			size_t const byte = _size - 1 - i;
+			if (byte >= 8 * N)
+			{
+				if (_data[i])
+					return false;
+				continue;
+			}
+			data[byte / 8] |= uint64_t(_data[i]) << (8 * (byte % 8));
+		}
+		return true;
+	}
+
+	/// Writes the number as @a _size big-endian bytes, truncating if necessary.
+	void toBigEndian(uint8_t* o_data, size_t _size) const
+	{
+		for (size_t i = 0; i < _size; ++i)
+		{
+			size_t const byte = _size - 1 - i;
+			o_data[i] = byte < 8 * N ? uint8_t(data[byte / 8] >> (8 * (byte % 8))) : 0;
+		}
+	}
+
+	friend constexpr bool operator==(BigInt const& _a, BigInt const& _b)
+	{
+		for (size_t i = 0; i < N; ++i)
+			if (_a.data[i] != _b.data[i])
+				return false;
+		return true;
+	}
+	friend constexpr bool operator!=(BigInt const& _a, BigInt const& _b) { return !(_a == _b); }
+
+	friend constexpr bool operator<(BigInt const& _a, BigInt const& _b)
+	{
+		for (size_t i = N; i-- > 0;)
+			if (_a.data[i] != _b.data[i])
+				return _a.data[i] < _b.data[i];
+		return false;
+	}
+	friend constexpr bool operator>=(BigInt const& _a, BigInt const& _b) { return !(_a < _b); }
+};
+
+namespace bigint
+{
+
+using uint128 = unsigned __int128;
+
+/// o_r = _a + _b; @returns the carry.
+template <size_t N>
+constexpr uint64_t add(BigInt<N>& o_r, BigInt<N> const& _a, BigInt<N> const& _b)
+{
+	uint64_t carry = 0;
+	for (size_t i = 0; i < N; ++i)
+	{
+		uint128 const t = uint128(_a.data[i]) + _b.data[i] + carry;
+		o_r.data[i] = uint64_t(t);
+		carry = uint64_t(t >> 64);
+	}
+	return carry;
+}
+
+/// o_r = _a - _b; @returns the borrow.
+template <size_t N>
+constexpr uint64_t sub(BigInt<N>& o_r, BigInt<N> const& _a, BigInt<N> const& _b)
+{
+	uint64_t borrow = 0;
+	for (size_t i = 0; i < N; ++i)
+	{
+		uint128 const t = uint128(_a.data[i]) - _b.data[i] - borrow;
+		o_r.data[i] = uint64_t(t);
+		borrow = uint64_t(t >> 64) & 1;
+	}
+	return borrow;
+}
+
+/// Addition with carry in and out; the carries are 0 or 1.
+inline uint64_t addCarry(uint64_t _a, uint64_t _b, uint64_t _carry, uint64_t& o_r)
+{
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+	unsigned long long r;
+	uint64_t const carry = _addcarry_u64((unsigned char)_carry, _a, _b, &r);
+	o_r = r;
+	return carry;
+#else
+	uint128 const t = uint128(_a) + _b + _carry;
+	o_r = uint64_t(t);
+	return uint64_t(t >> 64);
+#endif
+}
+
+/// Subtraction with borrow in and out; the borrows are 0 or 1.
+inline uint64_t subBorrow(uint64_t _a, uint64_t _b, uint64_t _borrow, uint64_t& o_r)
+{
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+	unsigned long long r;
+	uint64_t const borrow = _subborrow_u64((unsigned char)_borrow, _a, _b, &r);
+	o_r = r;
+	return borrow;
+#else
+	uint128 const t = uint128(_a) - _b - _borrow;
+	o_r = uint64_t(t);
+	return uint64_t(t >> 64) & 1;
+#endif
+}
+
+template <size_t N>
+constexpr BigInt<N> shiftRight1(BigInt<N> const& _a)
+{
+	BigInt<N> r{};
+	for (size_t i = 0; i < N; ++i)
+		r.data[i] = (_a.data[i] >> 1) | (i + 1 < N ? _a.data[i + 1] << 63 : 0);
+	return r;
+}
+
+/// @returns 2 * _a mod _m for _a < _m < 2^(64 N - 1).
+template <size_t N>
+constexpr BigInt<N> doubleMod(BigInt<N> const& _a, BigInt<N> const& _m)
+{
+	BigInt<N> r{};
+	add(r, _a, _a);
+	if (r >= _m)
+		sub(r, r, _m);
+	return r;
+}
+
+/// @returns 2^_bits mod _m.
+template <size_t N>
+constexpr BigInt<N> powerOfTwoMod(size_t _bits, BigInt<N> const& _m)
+{
+	BigInt<N> r{};
+	r.data[0] = 1;
+	for (size_t i = 0; i < _bits; ++i)
+		r = doubleMod(r, _m);
+	return r;
+}
+
+/// @returns -_m^-1 mod 2^64 for odd _m.
+constexpr uint64_t negInverse64(uint64_t _m)
+{
+	uint64_t inv = 1;
+	for (int i = 0; i < 6; ++i)
+		inv *= 2 - _m * inv;
+	return ~inv + 1;
+}
+
+/// @returns _a / _d, discarding the remainder.
+template <size_t N>
+constexpr BigInt<N> divSmall(BigInt<N> const& _a, uint64_t _d)
+{
+	BigInt<N> q{};
+	uint128 rem = 0;
+	for (size_t i = N; i-- > 0;)
+	{
+		uint128 const cur = (rem << 64) | _a.data[i];
+		q.data[i] = uint64_t(cur / _d);
+		rem = cur % _d;
+	}
+	return q;
+}
+
+template <size_t N>
+constexpr BigInt<N> addSmall(BigInt<N> _a, uint64_t _b)
+{
+	for (size_t i = 0; i < N && _b; ++i)
+	{
+		_a.data[i] += _b;
+		_b = _a.data[i] < _b;
+	}
+	return _a;
+}
+
+template <size_t N>
+constexpr BigInt<N> subSmall(BigInt<N> _a, uint64_t _b)
+{
+	for (size_t i = 0; i < N && _b; ++i)
+	{
+		uint64_t const borrow = _a.data[i] < _b;
+		_a.data[i] -= _b;
+		_b = borrow;
+	}
+	return _a;
+}
+
+}
+
+/// Element of the prime field given by Params::modulus(), kept in Montgomery form.
+///
+/// Params must provide:
+///   static constexpr size_t limbs;
+///   static constexpr BigInt<limbs> modulus();
+template <class Params>
+class MontgomeryField
+{
+public:
+	static constexpr size_t N = Params::limbs;
+	using Int = BigInt<N>;
+
+	static constexpr Int c_modulus = Params::modulus();
+	static constexpr uint64_t c_inv = bigint::negInverse64(c_modulus.data[0]);
+	/// R mod p, i.e. one in Montgomery form.
+	static constexpr Int c_r = bigint::powerOfTwoMod(64 * N, c_modulus);
+	/// R^2 mod p, used to convert into Montgomery form.
+	static constexpr Int c_r2 = bigint::powerOfTwoMod(128 * N, c_modulus);
+	/// p - 2, the exponent of the Fermat inversion.
+	static constexpr Int c_modulusMinusTwo = bigint::subSmall(c_modulus, 2);
+
+	static_assert(c_modulus.data[0] & 1, "Montgomery arithmetic requires an odd modulus.");
+	static_assert(c_modulus.data[N - 1] < 0x7fffffffffffffff, "No-carry CIOS requires a spare bit in the top limb.");
+
+	MontgomeryField(): m_v{} {}
+
+	/// Constructs a small constant.
+	explicit MontgomeryField(uint64_t _v)
+	{
+		Int a{};
+		a.data[0] = _v;
+		montMul(m_v, a, c_r2);
+	}
+
+	static MontgomeryField zero() { return MontgomeryField(); }
+	static MontgomeryField one() { return fromMontgomery(c_r); }
+	static MontgomeryField fromMontgomery(Int const& _v) { MontgomeryField x; x.m_v = _v; return x; }
+
+	/// Converts a canonical representative into Montgomery form.
+	/// @returns false if @a _v is not smaller than the modulus.
+	static bool fromCanonical(Int const& _v, MontgomeryField& o_x)
+	{
+		if (_v >= c_modulus)
+			return false;
+		montMul(o_x.m_v, _v, c_r2);
+		return true;
+	}
+
+	/// Reduces an arbitrary N limb integer modulo p.
+	static MontgomeryField reduce(Int _v)
+	{
+		while (_v >= c_modulus)
+			bigint::sub(_v, _v, c_modulus);
+		MontgomeryField x;
+		montMul(x.m_v, _v, c_r2);
+		return x;
+	}
+
+	/// @returns the canonical representative in [0, p).
+	Int toCanonical() const
+	{
+		Int one{};
+		one.data[0] = 1;
+		Int r;
+		montMul(r, m_v, one);
+		return r;
+	}
+
+	Int const& montgomery() const { return m_v; }
+
+	bool isZero() const { return m_v.isZero(); }
+	bool isOne() const { return m_v == c_r; }
+
+	bool operator==(MontgomeryField const& _b) const { return m_v == _b.m_v; }
+	bool operator!=(MontgomeryField const& _b) const { return !(m_v == _b.m_v); }
+
+	MontgomeryField operator+(MontgomeryField const& _b) const
+	{
+		MontgomeryField r;
+		uint64_t carry = 0;
+		DEV_UNROLL
+		for (size_t i = 0; i < N; ++i)
+			carry = bigint::addCarry(m_v.data[i], _b.m_v.data[i], carry, r.m_v.data[i]);
+		reduceOnce(r.m_v);
+		return r;
+	}
+
+	MontgomeryField operator-(MontgomeryField const& _b) const
+	{
+		MontgomeryField r;
+		uint64_t borrow = 0;
+		DEV_UNROLL
+		for (size_t i = 0; i < N; ++i)
+			borrow = bigint::subBorrow(m_v.data[i], _b.m_v.data[i], borrow, r.m_v.data[i]);
+		uint64_t const mask = uint64_t(0) - borrow;
+		uint64_t carry = 0;
+		DEV_UNROLL
+		for (size_t i = 0; i < N; ++i)
+			carry = bigint::addCarry(r.m_v.data[i], c_modulus.data[i] & mask, carry, r.m_v.data[i]);
+		return r;
+	}
+
+	MontgomeryField operator-() const { return zero() - *this; }
+
+	MontgomeryField operator*(MontgomeryField const& _b) const
+	{
+		MontgomeryField r;
+		montMul(r.m_v, m_v, _b.m_v);
+		return r;
+	}
+
+	MontgomeryField& operator+=(MontgomeryField const& _b) { return *this = *this + _b; }
+	MontgomeryField& operator-=(MontgomeryField const& _b) { return *this = *this - _b; }
+	MontgomeryField& operator*=(MontgomeryField const& _b) { return *this = *this * _b; }
+
+	MontgomeryField dbl() const { return *this + *this; }
+
+	MontgomeryField squared() const
+	{
+		MontgomeryField r;
+		montMul(r.m_v, m_v, m_v);
+		return r;
+	}
+
+	/// Raises to a power using fixed 4-bit windows.
+	template <size_t M>
+	MontgomeryField pow(BigInt<M> const& _e) const
+	{
+		MontgomeryField table[16];
+		table[0] = one();
+		for (size_t i = 1; i < 16; ++i)
+			table[i] = table[i - 1] * *this;
+		MontgomeryField r = one();
+		for (size_t i = (_e.numBits() + 3) / 4; i-- > 0;)
+		{
+			r = r.squared().squared().squared().squared();
+			r *= table[_e.window(4 * i, 4)];
+		}
+		return r;
+	}
+
+	/// @returns the multiplicative inverse (Fermat), zero for zero.
+	MontgomeryField inverse() const { return pow(c_modulusMinusTwo); }
+
+	/// Square root for p = 3 mod 4, which is a^((p + 1) / 4) if it exists.
+	/// @returns false if the element is not a square.
+	bool sqrt(MontgomeryField& o_root) const
+	{
+		static_assert((c_modulus.data[0] & 3) == 3, "sqrt requires p = 3 mod 4.");
+		static constexpr Int exponent = bigint::divSmall(bigint::addSmall(c_modulus, 1), 4);
+		o_root = pow(exponent);
+		return o_root.squared() == *this;
+	}
+
+	/// @returns true if the canonical representative is larger than (p - 1) / 2.
+	bool isLexicographicallyLargest() const
+	{
+		static constexpr Int half = bigint::shiftRight1(c_modulus);
+		return half < toCanonical();
+	}
+
+	/// Euler's criterion. @returns true for zero and the non-zero squares.
+	bool isSquare() const
+	{
+		static constexpr Int exponent = bigint::shiftRight1(bigint::subSmall(c_modulus, 1));
+		MontgomeryField const legendre = pow(exponent);
+		return legendre.isZero() | legendre.isOne();
+	}
+
+	/// @returns the parity of the canonical representative (sgn0 of RFC 9380).
+	bool isOdd() const { return toCanonical().data[0] & 1; }
+
+	/// @returns @a _ifTrue if @a _condition holds and @a _ifFalse otherwise
+	/// without branching on the condition.
+	static MontgomeryField select(bool _condition, MontgomeryField const& _ifTrue, MontgomeryField const& _ifFalse)
+	{
+		uint64_t const mask = 0 - uint64_t(_condition);
+		MontgomeryField r;
+		for (size_t i = 0; i < N; ++i)
+			r.m_v.data[i] = (_ifTrue.m_v.data[i] & mask) | (_ifFalse.m_v.data[i] & ~mask);
+		return r;
+	}
+
+private:
+	/// Subtracts the modulus once if @a io_v is not smaller than it.
+	static void reduceOnce(Int& io_v)
+	{
+		uint64_t t[N];
+		uint64_t borrow = 0;
+		DEV_UNROLL
+		for (size_t i = 0; i < N; ++i)
+			borrow = bigint::subBorrow(io_v.data[i], c_modulus.data[i], borrow, t[i]);
+		DEV_UNROLL
+		for (size_t i = 0; i < N; ++i)
+			io_v.data[i] = borrow ? io_v.data[i] : t[i];
+	}
+
+	static void montMul(Int& o_r, Int const& _a, Int const& _b)
+	{
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+		if (N == 4 && g_hasBmi2Adx)
+		{
+			montMul4Bmi2Adx(o_r.data, _a.data, _b.data);
+			reduceOnce(o_r);
+			return;
+		}
+#endif
+		montMulPortable(o_r, _a, _b);
+		reduceOnce(o_r);
+	}
+
+	/// CIOS Montgomery multiplication without the extra carry word. The result
+	/// is smaller than 2p.
+	static void montMulPortable(Int& o_r, Int const& _a, Int const& _b)
+	{
+		using bigint::uint128;
+		uint64_t t[N] = {};
+		DEV_UNROLL
+		for (size_t i = 0; i < N; ++i)
+		{
+			uint128 s = uint128(_a.data[0]) * _b.data[i] + t[0];
+			t[0] = uint64_t(s);
+			uint64_t a = uint64_t(s >> 64);
+			uint64_t const m = t[0] * c_inv;
+			uint128 c = uint128(m) * c_modulus.data[0] + t[0];
+			uint64_t carry = uint64_t(c >> 64);
+			DEV_UNROLL
+			for (size_t j = 1; j < N; ++j)
+			{
+				s = uint128(_a.data[j]) * _b.data[i] + t[j] + a;
+				a = uint64_t(s >> 64);
+				c = uint128(m) * c_modulus.data[j] + uint64_t(s) + carry;
+				t[j - 1] = uint64_t(c);
+				carry = uint64_t(c >> 64);
+			}
+			t[N - 1] = carry + a;
+		}
+		DEV_UNROLL
+		for (size_t i = 0; i < N; ++i)
+			o_r.data[i] = t[i];
+	}
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+	/// Four limb CIOS with two independent carry chains (ADCX/ADOX). The five
+	/// accumulator registers rotate by one position per outer iteration so the
+	/// division by 2^64 is free.
+	__attribute__((always_inline)) static void montMul4Bmi2Adx(uint64_t* o_r, uint64_t const* _a, uint64_t const* _b)
+	{
+#define DEV_MONT_MUL_STEP(B, T0, T1, T2, T3, T4) \
+		"movq " B ", %%rdx\n\t" \
+		"xorl %k[z], %k[z]\n\t" \
+		"mulxq 0(%[a]), %[lo], %[hi]\n\t" \
+		"adoxq %[lo], " T0 "\n\t" \
+		"adcxq %[hi], " T1 "\n\t" \
+		"mulxq 8(%[a]), %[lo], %[hi]\n\t" \
+		"adoxq %[lo], " T1 "\n\t" \
+		"adcxq %[hi], " T2 "\n\t" \
+		"mulxq 16(%[a]), %[lo], %[hi]\n\t" \
+		"adoxq %[lo], " T2 "\n\t" \
+		"adcxq %[hi], " T3 "\n\t" \
+		"mulxq 24(%[a]), %[lo], %[hi]\n\t" \
+		"adoxq %[lo], " T3 "\n\t" \
+		"adcxq %[hi], " T4 "\n\t" \
+		"adoxq %[z], " T4 "\n\t" \
+		"movq " T0 ", %%rdx\n\t" \
+		"imulq %[inv], %%rdx\n\t" \
+		"xorl %k[z], %k[z]\n\t" \
+		"mulxq 0(%[q]), %[lo], %[hi]\n\t" \
+		"adoxq %[lo], " T0 "\n\t" \
+		"adcxq %[hi], " T1 "\n\t" \
+		"mulxq 8(%[q]), %[lo], %[hi]\n\t" \
+		"adoxq %[lo], " T1 "\n\t" \
+		"adcxq %[hi], " T2 "\n\t" \
+		"mulxq 16(%[q]), %[lo], %[hi]\n\t" \
+		"adoxq %[lo], " T2 "\n\t" \
+		"adcxq %[hi], " T3 "\n\t" \
+		"mulxq 24(%[q]), %[lo], %[hi]\n\t" \
+		"adoxq %[lo], " T3 "\n\t" \
+		"adcxq %[hi], " T4 "\n\t" \
+		"adoxq %[z], " T4 "\n\t"
+
+		uint64_t t0 = 0, t1 = 0, t2 = 0, t3 = 0, t4 = 0, lo, hi, z;
+		__asm__(
+			DEV_MONT_MUL_STEP("0(%[b])", "%[t0]", "%[t1]", "%[t2]", "%[t3]", "%[t4]")
+			DEV_MONT_MUL_STEP("8(%[b])", "%[t1]", "%[t2]", "%[t3]", "%[t4]", "%[t0]")
+			DEV_MONT_MUL_STEP("16(%[b])", "%[t2]", "%[t3]", "%[t4]", "%[t0]", "%[t1]")
+			DEV_MONT_MUL_STEP("24(%[b])", "%[t3]", "%[t4]", "%[t0]", "%[t1]", "%[t2]")
+			: [t0] "+&r"(t0), [t1] "+&r"(t1), [t2] "+&r"(t2), [t3] "+&r"(t3), [t4] "+&r"(t4),
+			  [lo] "=&r"(lo), [hi] "=&r"(hi), [z] "=&r"(z)
+			: [a] "r"(_a), [b] "r"(_b), [q] "r"(c_modulus.data), [inv] "rm"(c_inv)
+			: "rdx", "cc", "memory"
+		);
+#undef DEV_MONT_MUL_STEP
+		o_r[0] = t4;
+		o_r[1] = t0;
+		o_r[2] = t1;
+		o_r[3] = t2;
+	}
+#endif
+
+	Int m_v;
+};
+
+template <class Params> constexpr size_t MontgomeryField<Params>::N;
+template <class Params> constexpr typename MontgomeryField<Params>::Int MontgomeryField<Params>::c_modulus;
+template <class Params> constexpr uint64_t MontgomeryField<Params>::c_inv;
+template <class Params> constexpr typename MontgomeryField<Params>::Int MontgomeryField<Params>::c_r;
+template <class Params> constexpr typename MontgomeryField<Params>::Int MontgomeryField<Params>::c_r2;
+template <class Params> constexpr typename MontgomeryField<Params>::Int MontgomeryField<Params>::c_modulusMinusTwo;
+
+}
+}
@@ -0,0 +1,260 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2014-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+
+#include <libdevcrypto/Ntt.h>
+#include <libdevcrypto/Exceptions.h>
+
+#include <algorithm>
+#include <cassert>
+#include <thread>
+
+using namespace std;
+using namespace dev;
+using namespace dev::crypto;
+using namespace dev::crypto::alt_bn128;
+
+namespace
+{
+
+/// Largest domain transformed in one piece: 2^16 elements are 2 MiB, about a
+/// core's share of the cache. Beyond that the passes over the whole array
+/// miss the cache and the four-step algorithm wins even on one core.
+unsigned constexpr c_maxDirectLog = 16;
+
+/// Side of the square blocks of the transposes; 16 elements are 512 bytes.
+size_t constexpr c_transposeBlock = 16;
+
+/// Elements copied per thread at least; fewer cost less than a thread start.
+size_t constexpr c_minCopyChunk = 1 << 14;
+
+/// Runs _work(begin, end) over [0, _count) split across all cores, with at
+/// least @a _minChunk items per thread. Counts below 2 * @a _minChunk run
+/// inline.
+template <class Work>
+void parallelFor(size_t _count, size_t _minChunk, Work const& _work)
+{
+	size_t const threads = min<size_t>(_count / _minChunk, max(1u, thread::hardware_concurrency()));
+	if (threads <= 1)
+	{
+		_work(size_t(0), _count);
+		return;
+	}
+	vector<thread> workers;
+	size_t const chunk = (_count + threads - 1) / threads;
+	for (size_t begin = 0; begin < _count; begin += chunk)
+		workers.emplace_back(_work, begin, min(_count, begin + chunk));
+	for (auto& worker: workers)
+		worker.join();
+}
+
+vector<Fr> powers(Fr const& _x, size_t _count)
+{
+	vector<Fr> result(_count);
+	Fr p = Fr::one();
+	for (auto& r: result)
+	{
+		r = p;
+		p *= _x;
+	}
+	return result;
+}
+
+Fr power(Fr const& _x, size_t _e)
+{
+	BigInt<1> const e{{_e}};
+	return _x.pow(e);
+}
+
+void bitReverse(Fr* io_values, unsigned _log)
+{
+	size_t const n = size_t(1) << _log;
+	for (size_t i = 1, j = 0; i < n; ++i)
+	{
+		size_t bit = n >> 1;
+		for (; j & bit; bit >>= 1)
+			j ^= bit;
+		j ^= bit;
+		if (i < j)
+			swap(io_values[i], io_values[j]);
+	}
+}
+
+/// Transforms 2^@a _log values in place, given root^i for i < 2^(_log - 1):
+/// bit reversal, then decimation in time with radix-4 passes, preceded by one
+/// radix-2 pass for an odd @a _log.
+void transformInPlace(Fr* io_values, unsigned _log, Fr const* _twiddles)
+{
+	size_t const n = size_t(1) << _log;
+	bitReverse(io_values, _log);
+
+	size_t half = 1;
+	if (_log & 1)
+	{
+		for (size_t i = 0; i < n; i += 2)
+		{
+			Fr const u = io_values[i];
+			io_values[i] = u + io_values[i + 1];
+			io_values[i + 1] = u - io_values[i + 1];
+		}
+		half = 2;
+	}
+
+	// A radix-4 pass does the radix-2 passes of half sizes h and 2h at once:
+	// four values at distance h are combined with root^(n/2h) and
+	// root^(n/4h) twiddles, four multiplications per group.
+	for (; half < n; half *= 4)
+	{
+		size_t const stride = n / (4 * half);
+		for (size_t block = 0; block < n; block += 4 * half)
+			for (size_t j = 0; j < half; ++j)
+			{
+				Fr* a = io_values + block + j;
+				Fr const w1 = _twiddles[2 * j * stride];
+				Fr const a1 = a[half] * w1;
+				Fr const a3 = a[3 * half] * w1;
+				Fr const b0 = a[0] + a1;
+				Fr const b1 = a[0] - a1;
+				Fr const b2 = (a[2 * half] + a3) * _twiddles[j * stride];
+				Fr const b3 = (a[2 * half] - a3) * _twiddles[(j + half) * stride];
+				a[0] = b0 + b2;
+				a[2 * half] = b0 - b2;
+				a[half] = b1 + b3;
+				a[3 * half] = b1 - b3;
+			}
+	}
+}
+
+/// Writes the transpose of the row-major @a _rows x @a _columns matrix
+/// @a _in to @a o_out, one block of rows per task.
+void transpose(Fr const* _in, Fr* o_out, size_t _rows, size_t _columns)
+{
+	size_t const B = c_transposeBlock;
+	parallelFor((_rows + B - 1) / B, 1, [=](size_t _begin, size_t _end) {
+		for (size_t rowBlock = _begin * B; rowBlock < min(_rows, _end * B); rowBlock += B)
+			for (size_t columnBlock = 0; columnBlock < _columns; columnBlock += B)
+				for (size_t r = rowBlock; r < min(_rows, rowBlock + B); ++r)
+					for (size_t c = columnBlock; c < min(_columns, columnBlock + B); ++c)
+						o_out[c * _rows + r] = _in[r * _columns + c];
+	});
+}
+
+}
+
+Fr alt_bn128::rootOfUnity(unsigned _log)
+{
+	assert(_log <= c_frTwoAdicity);
+	// 5 is a quadratic non-residue, so this root has order exactly 2^_log.
+	return Fr(5).pow(bigint::divSmall(bigint::subSmall(Fr::c_modulus, 1), uint64_t(1) << _log));
+}
+
+NttDomain::NttDomain(size_t _size):
+	m_size(_size),
+	m_log(0)
+{
+	if (_size == 0 || (_size & (_size - 1)) || _size > (size_t(1) << c_frTwoAdicity))
+		BOOST_THROW_EXCEPTION(InvalidDomainSize());
+	while ((size_t(1) << m_log) < _size)
+		++m_log;
+	if (m_log > c_maxDirectLog)
+	{
+		m_firstLog = m_log / 2;
+		m_secondLog = m_log - m_firstLog;
+	}
+
+	m_omega = rootOfUnity(m_log);
+	m_sizeInverse = Fr(_size).inverse();
+	m_forward = makeTwiddles(m_omega);
+	m_inverse = makeTwiddles(m_omega.inverse());
+}
+
+NttDomain::Twiddles NttDomain::makeTwiddles(Fr const& _root) const
+{
+	Twiddles twiddles;
+	if (m_firstLog == 0)
+		twiddles.whole = powers(_root, m_size / 2);
+	else
+	{
+		size_t const firstSize = size_t(1) << m_firstLog;
+		size_t const secondSize = size_t(1) << m_secondLog;
+		twiddles.first = powers(power(_root, secondSize), firstSize / 2);
+		twiddles.second = powers(power(_root, firstSize), secondSize / 2);
+		twiddles.steps = powers(_root, secondSize);
+	}
+	return twiddles;
+}
+
+Fr NttDomain::element(size_t _i) const
+{
+	return power(m_omega, _i % m_size);
+}
+
+void NttDomain::transform(Fr* io_values, Twiddles const& _twiddles, Fr const& _scale) const
+{
+	if (m_firstLog == 0)
+	{
+		transformInPlace(io_values, m_log, _twiddles.whole.data());
+		// At most 2^c_maxDirectLog values, which are still in cache.
+		if (!_scale.isOne())
+			for (size_t i = 0; i < m_size; ++i)
+				io_values[i] *= _scale;
+		return;
+	}
+
+	// With value j1 * n2 + j2 at row j1, column j2 of an n1 x n2 matrix and
+	// output k1 + n1 * k2, omega^(jk) = omega^(n2 j1 k1) omega^(j2 k1)
+	// omega^(n1 j2 k2): transforms of length n1 down the columns, a twiddle
+	// multiplication, transforms of length n2 along the rows. Transposes
+	// make all of them contiguous. The scale is folded into the twiddle
+	// multiplication.
+	size_t const n1 = size_t(1) << m_firstLog;
+	size_t const n2 = size_t(1) << m_secondLog;
+	vector<Fr> scratch(m_size);
+	transpose(io_values, scratch.data(), n1, n2);
+	parallelFor(n2, 1, [&](size_t _begin, size_t _end) {
+		for (size_t j2 = _begin; j2 < _end; ++j2)
+		{
+			Fr* column = scratch.data() + j2 * n1;
+			transformInPlace(column, m_firstLog, _twiddles.first.data());
+			Fr const step = _twiddles.steps[j2];
+			Fr w = _scale;
+			for (size_t k1 = 0; k1 < n1; ++k1)
+			{
+				column[k1] *= w;
+				w *= step;
+			}
+		}
+	});
+	transpose(scratch.data(), io_values, n2, n1);
+	parallelFor(n1, 1, [&](size_t _begin, size_t _end) {
+		for (size_t k1 = _begin; k1 < _end; ++k1)
+			transformInPlace(io_values + k1 * n2, m_secondLog, _twiddles.second.data());
+	});
+	transpose(io_values, scratch.data(), n1, n2);
+	parallelFor(m_size, c_minCopyChunk, [&](size_t _begin, size_t _end) {
+		copy(scratch.begin() + _begin, scratch.begin() + _end, io_values + _begin);
+	});
+}
+
+void NttDomain::ntt(Fr* io_values) const
+{
+	transform(io_values, m_forward, Fr::one());
+}
+
+void NttDomain::ntt(vector<Fr>& io_values) const
+{
+	assert(io_values.size() <= m_size);
+	io_values.resize(m_size);
+	ntt(io_values.data());
+}
+
+void NttDomain::inverseNtt(Fr* io_values) const
+{
+	transform(io_values, m_inverse, m_sizeInverse);
+}
+
+void NttDomain::inverseNtt(vector<Fr>& io_values) const
+{
+	assert(io_values.size() == m_size);
+	inverseNtt(io_values.data());
+}
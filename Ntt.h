@@ -0,0 +1,95 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2014-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+/** @file Ntt.h
+ * Number-theoretic transforms over the scalar field of alt_bn128, i.e.
+ * evaluation of polynomials on the powers of a root of unity of order 2^k
+ * and interpolation back, as needed by PLONK and KZG.
+ */
+
+#pragma once
+
+#include <libdevcrypto/Bn254.h>
+
+#include <vector>
+
+namespace dev
+{
+namespace crypto
+{
+namespace alt_bn128
+{
+
+/// r - 1 is divisible by 2^28 but not 2^29, which bounds the domain size.
+unsigned constexpr c_frTwoAdicity = 28;
+
+/// The root of unity of order 2^@a _log that generates NttDomain(2^_log),
+/// for @a _log up to c_frTwoAdicity.
+Fr rootOfUnity(unsigned _log);
+
+/// The subgroup of the 2^k-th roots of unity with the twiddle factors of its
+/// transforms.
+///
+/// Domains that fit the cache are transformed by radix-4 passes (radix-2 for
+/// an odd power) over the whole array. Larger ones use the four-step
+/// algorithm on a 2^(k/2) x 2^(k - k/2) matrix: row transforms, one twiddle
+/// multiplication, row transforms of the transpose, all rows in cache and
+/// spread over all cores.
+class NttDomain
+{
+public:
+	/// Throws InvalidDomainSize unless @a _size is a power of two no larger
+	/// than 2^c_frTwoAdicity.
+	explicit NttDomain(size_t _size);
+
+	size_t size() const { return m_size; }
+	/// The root of unity omega of order size().
+	Fr const& generator() const { return m_omega; }
+	/// omega^@a _i.
+	Fr element(size_t _i) const;
+
+	/// Replaces the coefficients a_0, ..., a_{n-1} of a polynomial of degree
+	/// below n = size() with its values at omega^0, ..., omega^{n-1}.
+	void ntt(Fr* io_values) const;
+	/// Pads @a io_values with zero coefficients to size() first.
+	void ntt(std::vector<Fr>& io_values) const;
+	/// Interpolates: replaces the values at omega^0, ..., omega^{n-1} with
+	/// the coefficients.
+	void inverseNtt(Fr* io_values) const;
+	void inverseNtt(std::vector<Fr>& io_values) const;
+
+private:
+	/// Twiddle factors of one transform direction.
+	struct Twiddles
+	{
+		/// root^i for i < n / 2 if the domain is transformed in one piece.
+		std::vector<Fr> whole;
+		/// The same for the transforms of length 2^m_firstLog and
+		/// 2^m_secondLog of the four-step algorithm.
+		std::vector<Fr> first;
+		std::vector<Fr> second;
+		/// root^i for i < 2^m_secondLog, the steps of the twiddle
+		/// multiplication between them.
+		std::vector<Fr> steps;
+	};
+
+	/// Transforms @a io_values and multiplies them by @a _scale.
+	void transform(Fr* io_values, Twiddles const& _twiddles, Fr const& _scale) const;
+	Twiddles makeTwiddles(Fr const& _root) const;
+
+	size_t m_size;
+	unsigned m_log;
+	/// The four-step algorithm transforms 2^m_secondLog columns of length
+	/// 2^m_firstLog, then 2^m_firstLog rows of length 2^m_secondLog. Both
+	/// are zero for domains transformed in one piece.
+	unsigned m_firstLog = 0;
+	unsigned m_secondLog = 0;
+	Fr m_omega;
+	Fr m_sizeInverse;
+	Twiddles m_forward;
+	Twiddles m_inverse;
+};
+
+}
+}
+}
@@ -0,0 +1,225 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2014-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+
+#include "Plonk.h"
+#include "Exceptions.h"
+#include "MultiScalarMul.h"
+#include "Ntt.h"
+
+using namespace std;
+using namespace dev;
+using namespace dev::crypto;
+using namespace dev::crypto::alt_bn128;
+
+namespace
+{
+
+/// The Fiat-Shamir transcript of snarkjs: points as x | y and scalars as
+/// 32 byte big-endian numbers, every challenge the Keccak-256 hash of what
+/// was added since the previous one, reduced modulo r.
+class Transcript
+{
+public:
+	explicit Transcript(Keccak256 const& _state = Keccak256()): m_hash(_state) {}
+
+	/// @a _p must be in affine form or zero, which is added as 64 zero bytes.
+	void add(G1 const& _p)
+	{
+		byte data[64] = {};
+		if (!_p.isZero())
+		{
+			_p.x.toCanonical().toBigEndian(data, 32);
+			_p.y.toCanonical().toBigEndian(data + 32, 32);
+		}
+		m_hash.update(bytesConstRef(data, sizeof(data)));
+	}
+
+	void add(Fr const& _x)
+	{
+		byte data[32];
+		_x.toCanonical().toBigEndian(data, sizeof(data));
+		m_hash.update(bytesConstRef(data, sizeof(data)));
+	}
+
+	Fr challenge()
+	{
+		h256 const hash = m_hash.digest();
+		m_hash = Keccak256();
+		Fr::Int v;
+		v.fromBigEndian(hash.data(), hash.size);
+		return Fr::reduce(v);
+	}
+
+	Keccak256 const& state() const { return m_hash; }
+
+private:
+	Keccak256 m_hash;
+};
+
+FixedBaseTable<G1> tableOf(G1 const& _p)
+{
+	return FixedBaseTable<G1>(_p, Fr::c_modulus.numBits());
+}
+
+}
+
+PlonkVerifier::PlonkVerifier(PlonkVerifyingKey const& _vk):
+	m_power(_vk.power),
+	m_inputs(_vk.publicInputs),
+	m_k1(_vk.k1),
+	m_k2(_vk.k2),
+	m_qc(_vk.qc.toAffine()),
+	m_qm(tableOf(_vk.qm)),
+	m_ql(tableOf(_vk.ql)),
+	m_qr(tableOf(_vk.qr)),
+	m_qo(tableOf(_vk.qo)),
+	m_s1(tableOf(_vk.s1)),
+	m_s2(tableOf(_vk.s2)),
+	m_s3(tableOf(_vk.s3)),
+	m_x2(prepareG2OrEmpty(_vk.x2)),
+	m_g2(prepareG2(g2Generator()))
+{
+	if (m_power > c_frTwoAdicity)
+		BOOST_THROW_EXCEPTION(InvalidDomainSize());
+	m_omega = rootOfUnity(m_power);
+	m_size = Fr(uint64_t(1) << m_power);
+
+	// Every transcript starts with the commitments of the key.
+	G1 commitments[] = {_vk.qm, _vk.ql, _vk.qr, _vk.qo, _vk.qc, _vk.s1, _vk.s2, _vk.s3};
+	G1::batchToAffine(commitments, 8);
+	Transcript prefix;
+	for (auto const& c: commitments)
+		prefix.add(c);
+	m_transcript = prefix.state();
+}
+
+bool PlonkVerifier::verify(PlonkProof const& _proof, vector<Fr> const& _publicInputs) const
+{
+	if (_publicInputs.size() != m_inputs)
+		return false;
+	G1 points[] = {
+		_proof.a, _proof.b, _proof.c, _proof.z, _proof.t1, _proof.t2, _proof.t3, _proof.wxi, _proof.wxiw
+	};
+	for (auto const& p: points)
+		if (!p.isOnCurve())
+			return false;
+	G1::batchToAffine(points, 9);
+	G1 const& a = points[0];
+	G1 const& b = points[1];
+	G1 const& c = points[2];
+	G1 const& z = points[3];
+	G1 const& wxi = points[7];
+	G1 const& wxiw = points[8];
+
+	Transcript transcript(m_transcript);
+	for (auto const& x: _publicInputs)
+		transcript.add(x);
+	transcript.add(a);
+	transcript.add(b);
+	transcript.add(c);
+	Fr const beta = transcript.challenge();
+	transcript.add(beta);
+	Fr const gamma = transcript.challenge();
+	transcript.add(beta);
+	transcript.add(gamma);
+	transcript.add(z);
+	Fr const alpha = transcript.challenge();
+	transcript.add(alpha);
+	transcript.add(points[4]);
+	transcript.add(points[5]);
+	transcript.add(points[6]);
+	Fr const xi = transcript.challenge();
+	transcript.add(xi);
+	for (Fr const* e: {&_proof.evalA, &_proof.evalB, &_proof.evalC, &_proof.evalS1, &_proof.evalS2, &_proof.evalZw})
+		transcript.add(*e);
+	Fr const v1 = transcript.challenge();
+	transcript.add(wxi);
+	transcript.add(wxiw);
+	Fr const u = transcript.challenge();
+
+	Fr xin = xi;
+	for (unsigned i = 0; i < m_power; ++i)
+		xin = xin.squared();
+	Fr const zh = xin - Fr::one();
+
+	// L_i(xi) = omega^i * zh / (n * (xi - omega^i)) for the public inputs,
+	// at least L_1, with the denominators inverted together.
+	vector<Fr> lagrange(max<size_t>(1, m_inputs));
+	Fr w = Fr::one();
+	for (auto& l: lagrange)
+	{
+		l = m_size * (xi - w);
+		if (l.isZero())
+			return false;
+		w *= m_omega;
+	}
+	batchInvert(lagrange);
+	w = zh;
+	for (auto& l: lagrange)
+	{
+		l *= w;
+		w *= m_omega;
+	}
+
+	Fr pi = Fr::zero();
+	for (size_t i = 0; i < m_inputs; ++i)
+		pi -= lagrange[i] * _publicInputs[i];
+
+	Fr const& ea = _proof.evalA;
+	Fr const& eb = _proof.evalB;
+	Fr const& ec = _proof.evalC;
+	Fr const l1Alpha2 = lagrange[0] * alpha.squared();
+	Fr const permutationA = ea + beta * _proof.evalS1 + gamma;
+	Fr const permutationB = eb + beta * _proof.evalS2 + gamma;
+	Fr const r0 = pi - l1Alpha2 - permutationA * permutationB * (ec + gamma) * _proof.evalZw * alpha;
+
+	Fr const v2 = v1 * v1;
+	Fr const v3 = v2 * v1;
+	Fr const v4 = v3 * v1;
+	Fr const v5 = v4 * v1;
+	Fr const e = v1 * ea + v2 * eb + v3 * ec + v4 * _proof.evalS1 + v5 * _proof.evalS2 + u * _proof.evalZw - r0;
+
+	// The openings at xi and xi * omega batched with u: e(-W, [tau]_2) *
+	// e(F, G2) == 1 for W = Wxi + u Wxiw and F = xi Wxi + u xi omega Wxiw +
+	// D + v1 A + v2 B + v3 C + v4 S1 + v5 S2 - e G1, where D is the
+	// linearisation of the gate, permutation and quotient polynomials.
+	Fr const betaXi = beta * xi;
+	Fr const zScalar = (ea + betaXi + gamma) * (eb + betaXi * m_k1 + gamma) * (ec + betaXi * m_k2 + gamma) * alpha
+		+ l1Alpha2 + u;
+	Fr const s3Scalar = -(permutationA * permutationB * alpha * beta * _proof.evalZw);
+	Fr const tScalar = -zh;
+
+	vector<G1> msmPoints;
+	vector<Fr::Int> msmScalars;
+	auto term = [&](G1 const& _p, Fr const& _k) {
+		if (!_p.isZero())
+		{
+			msmPoints.push_back(_p);
+			msmScalars.push_back(_k.toCanonical());
+		}
+	};
+	term(wxi, xi);
+	term(wxiw, u * xi * m_omega);
+	term(z, zScalar);
+	term(points[4], tScalar);
+	term(points[5], tScalar * xin);
+	term(points[6], tScalar * xin.squared());
+	term(a, v1);
+	term(b, v2);
+	term(c, v3);
+	G1 f = multiScalarMul(move(msmPoints), msmScalars);
+	m_qm.mulAdd((ea * eb).toCanonical(), f);
+	m_ql.mulAdd(ea.toCanonical(), f);
+	m_qr.mulAdd(eb.toCanonical(), f);
+	m_qo.mulAdd(ec.toCanonical(), f);
+	m_s1.mulAdd(v4.toCanonical(), f);
+	m_s2.mulAdd(v5.toCanonical(), f);
+	m_s3.mulAdd(s3Scalar.toCanonical(), f);
+	g1GeneratorTable().mulAdd((-e).toCanonical(), f);
+	f = f.mixedAdd(m_qc);
+
+	G1 pairingPoints[2] = {-(wxi + wxiw.mul(u.toCanonical())), f};
+	G2Prepared const* lines[2] = {&m_x2, &m_g2};
+	return finalExponentiation(multiMillerLoopSkippingZero(pairingPoints, lines, 2)).isOne();
+}
@@ -0,0 +1,109 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2014-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+/** @file Plonk.h
+ * Verification of PLONK proofs over alt_bn128 with KZG commitments, in the
+ * variant generated by snarkjs ("protocol": "plonk") including its Keccak-256
+ * Fiat-Shamir transcript, so that proofs accepted by its verifier contract
+ * are accepted here.
+ */
+
+#pragma once
+
+#include "Bn254.h"
+#include "Hash.h"
+
+#include <vector>
+
+namespace dev
+{
+namespace crypto
+{
+namespace alt_bn128
+{
+
+struct PlonkVerifyingKey
+{
+	/// log2 of the domain size n.
+	unsigned power = 0;
+	size_t publicInputs = 0;
+	/// Coset shifts of the second and third wire.
+	Fr k1;
+	Fr k2;
+	G1 qm;
+	G1 ql;
+	G1 qr;
+	G1 qo;
+	G1 qc;
+	G1 s1;
+	G1 s2;
+	G1 s3;
+	/// [tau]_2 of the setup.
+	G2 x2;
+};
+
+struct PlonkProof
+{
+	G1 a;
+	G1 b;
+	G1 c;
+	G1 z;
+	G1 t1;
+	G1 t2;
+	G1 t3;
+	G1 wxi;
+	G1 wxiw;
+	Fr evalA;
+	Fr evalB;
+	Fr evalC;
+	Fr evalS1;
+	Fr evalS2;
+	Fr evalZw;
+};
+
+/// Verifies PLONK proofs against a fixed verifying key.
+///
+/// The constructor does all work that depends only on the key: fixed-base
+/// tables of the selector and permutation commitments, the Miller loop lines
+/// of [tau]_2 and of the G2 generator and the Keccak state after absorbing
+/// the key's commitments, which start every transcript. verify() folds both
+/// KZG openings into the check e(-W, [tau]_2) * e(F, G2) == 1: one
+/// multi-scalar multiplication for F, a 2-pair Miller loop and a single final
+/// exponentiation.
+class PlonkVerifier
+{
+public:
+	/// @a _vk must consist of valid group elements and have power at most
+	/// c_frTwoAdicity.
+	explicit PlonkVerifier(PlonkVerifyingKey const& _vk);
+
+	size_t inputCount() const { return m_inputs; }
+
+	/// @returns false if the proof is invalid, its points are not on the
+	/// curve or the number of public inputs does not match the key.
+	bool verify(PlonkProof const& _proof, std::vector<Fr> const& _publicInputs) const;
+
+private:
+	unsigned m_power;
+	size_t m_inputs;
+	Fr m_k1;
+	Fr m_k2;
+	/// Generator of the domain and its size as a field element.
+	Fr m_omega;
+	Fr m_size;
+	G1 m_qc;
+	FixedBaseTable<G1> m_qm;
+	FixedBaseTable<G1> m_ql;
+	FixedBaseTable<G1> m_qr;
+	FixedBaseTable<G1> m_qo;
+	FixedBaseTable<G1> m_s1;
+	FixedBaseTable<G1> m_s2;
+	FixedBaseTable<G1> m_s3;
+	G2Prepared m_x2;
+	G2Prepared m_g2;
+	Keccak256 m_transcript;
+};
+
+}
+}
+}
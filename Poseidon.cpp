@@ -0,0 +1,424 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2014-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+
+#include <libdevcrypto/Poseidon.h>
+#include <libdevcrypto/Exceptions.h>
+
+#include <algorithm>
+#include <cassert>
+#include <thread>
+
+using namespace std;
+using namespace dev;
+using namespace dev::crypto;
+using namespace dev::crypto::alt_bn128;
+
+namespace
+{
+
+/// Partial rounds of widths 2 to 17, as chosen by the reference script for
+/// 128-bit security with x^5 over a 254-bit field.
+size_t const c_partialRounds[] = {56, 57, 56, 60, 60, 63, 64, 63, 60, 66, 60, 65, 70, 60, 64, 68};
+
+/// Independent permutations interleaved by poseidonBatch to hide the latency
+/// of the field multiplications.
+size_t constexpr c_batchLanes = 4;
+
+/// The Grain LFSR of the Poseidon reference implementation, seeded with the
+/// instance parameters and filtered by self-shrinking.
+class GrainLfsr
+{
+public:
+	GrainLfsr(size_t _width, size_t _partialRounds)
+	{
+		// Prime field, x^alpha S-box, field size, width, rounds, then 30 ones.
+		push(1, 2);
+		push(0, 4);
+		push(Fr::c_modulus.numBits(), 12);
+		push(_width, 12);
+		push(c_poseidonFullRounds, 10);
+		push(_partialRounds, 10);
+		push((1 << 30) - 1, 30);
+		for (int i = 0; i < 160; ++i)
+			next();
+	}
+
+	/// @returns the next number of Fr::c_modulus.numBits() bits, most
+	/// significant bit first.
+	Fr::Int number()
+	{
+		Fr::Int v{};
+		for (size_t i = Fr::c_modulus.numBits(); i-- > 0;)
+			if (bit())
+				v.data[i / 64] |= uint64_t(1) << (i % 64);
+		return v;
+	}
+
+private:
+	/// Appends the @a _bits low bits of @a _v, most significant first.
+	void push(uint64_t _v, unsigned _bits)
+	{
+		for (unsigned i = _bits; i-- > 0;)
+			shiftIn((_v >> i) & 1);
+	}
+
+	/// Bit 0 of m_lo is the oldest of the 80 state bits, bit 15 of m_hi the
+	/// newest.
+	void shiftIn(uint64_t _bit)
+	{
+		m_lo = (m_lo >> 1) | (m_hi << 63);
+		m_hi = ((m_hi >> 1) | (_bit << 15)) & 0xffff;
+	}
+
+	bool next()
+	{
+		uint64_t const b = (m_lo ^ (m_lo >> 13) ^ (m_lo >> 23) ^ (m_lo >> 38) ^ (m_lo >> 51) ^ (m_lo >> 62)) & 1;
+		shiftIn(b);
+		return b;
+	}
+
+	bool bit()
+	{
+		while (!next())
+			next();
+		return next();
+	}
+
+	uint64_t m_lo = 0;
+	uint64_t m_hi = 0;
+};
+
+/// Solves @a _a x = @a _b for an invertible @a _n x @a _n matrix by
+/// Gauss-Jordan elimination.
+vector<Fr> solve(vector<Fr> _a, vector<Fr> _b, size_t _n)
+{
+	for (size_t col = 0; col < _n; ++col)
+	{
+		size_t pivot = col;
+		while (pivot < _n && _a[pivot * _n + col].isZero())
+			++pivot;
+		assert(pivot < _n);
+		if (pivot != col)
+		{
+			swap_ranges(_a.begin() + pivot * _n, _a.begin() + (pivot + 1) * _n, _a.begin() + col * _n);
+			swap(_b[pivot], _b[col]);
+		}
+		Fr const inverse = _a[col * _n + col].inverse();
+		for (size_t k = col; k < _n; ++k)
+			_a[col * _n + k] *= inverse;
+		_b[col] *= inverse;
+		for (size_t row = 0; row < _n; ++row)
+		{
+			Fr const f = _a[row * _n + col];
+			if (row == col || f.isZero())
+				continue;
+			for (size_t k = col; k < _n; ++k)
+				_a[row * _n + k] -= f * _a[col * _n + k];
+			_b[row] -= f * _b[col];
+		}
+	}
+	return _b;
+}
+
+/// Derives the sparse form of the partial rounds from the round constants and
+/// the MDS matrix.
+void makeOptimized(PoseidonParams& io_params)
+{
+	size_t const t = io_params.width;
+	size_t const n = t - 1;
+	size_t const firstPartial = c_poseidonFullRounds / 2;
+	size_t const firstFull = firstPartial + io_params.partialRounds;
+	vector<Fr> const& m = io_params.mds;
+
+	// The S-box of a partial round leaves elements 1.. alone, so their
+	// constants commute with it and pass through the linear layer into the
+	// constants of the next round, finally into the first full round.
+	vector<Fr> c = io_params.roundConstants;
+	for (size_t round = firstPartial; round < firstFull; ++round)
+	{
+		Fr const* current = &c[round * t];
+		Fr* next = &c[(round + 1) * t];
+		for (size_t i = 0; i < t; ++i)
+			for (size_t j = 1; j < t; ++j)
+				next[i] += m[i * t + j] * current[j];
+		io_params.partialConstants.push_back(current[0]);
+	}
+	io_params.fullConstants.assign(c.begin(), c.begin() + firstPartial * t);
+	io_params.fullConstants.insert(io_params.fullConstants.end(), c.begin() + firstFull * t, c.end());
+
+	// Every round's matrix A = M diag(1, H) with the H deferred by the round
+	// before factors into diag(1, B) S with B the lower right block of A and
+	// S = [[a00, row], [B^-1 column, I]]. diag(1, B) fixes the first element,
+	// so it commutes with the S-box and is deferred to the next round; the
+	// last one is applied after the partial rounds.
+	vector<Fr> h(n * n);
+	for (size_t i = 0; i < n; ++i)
+		h[i * n + i] = Fr::one();
+	vector<Fr> a(t * t);
+	vector<Fr> b(n * n);
+	vector<Fr> column(n);
+	for (size_t round = firstPartial; round < firstFull; ++round)
+	{
+		for (size_t i = 0; i < t; ++i)
+		{
+			a[i * t] = m[i * t];
+			for (size_t j = 1; j < t; ++j)
+			{
+				Fr sum;
+				for (size_t k = 1; k < t; ++k)
+					sum += m[i * t + k] * h[(k - 1) * n + j - 1];
+				a[i * t + j] = sum;
+			}
+		}
+		for (size_t i = 0; i < n; ++i)
+		{
+			column[i] = a[(i + 1) * t];
+			copy_n(&a[(i + 1) * t + 1], n, &b[i * n]);
+		}
+		io_params.sparseMatrices.insert(io_params.sparseMatrices.end(), a.begin(), a.begin() + t);
+		vector<Fr> const w = solve(b, column, n);
+		io_params.sparseMatrices.insert(io_params.sparseMatrices.end(), w.begin(), w.end());
+		h = b;
+	}
+	io_params.partialExit = move(h);
+}
+
+PoseidonParams makeParams(size_t _width)
+{
+	PoseidonParams params;
+	params.width = _width;
+	params.partialRounds = c_partialRounds[_width - c_poseidonMinWidth];
+	GrainLfsr lfsr(_width, params.partialRounds);
+
+	size_t const constants = (c_poseidonFullRounds + params.partialRounds) * _width;
+	params.roundConstants.reserve(constants);
+	while (params.roundConstants.size() < constants)
+	{
+		Fr c;
+		// Numbers outside the field are skipped.
+		if (Fr::fromCanonical(lfsr.number(), c))
+			params.roundConstants.push_back(c);
+	}
+
+	// M[i][j] = 1 / (x_i + y_j) with the next 2 * width numbers reduced into
+	// the field. The reference script would draw again if the matrix failed
+	// its security checks, which no width of this field does.
+	vector<Fr> x(2 * _width);
+	for (auto& v: x)
+		v = Fr::reduce(lfsr.number());
+	params.mds.resize(_width * _width);
+	for (size_t i = 0; i < _width; ++i)
+		for (size_t j = 0; j < _width; ++j)
+			params.mds[i * _width + j] = x[i] + x[_width + j];
+	batchInvert(params.mds);
+	makeOptimized(params);
+	return params;
+}
+
+template <size_t Width>
+PoseidonParams const& paramsOf()
+{
+	static PoseidonParams const s_params = makeParams(Width);
+	return s_params;
+}
+
+inline Fr pow5(Fr const& _x)
+{
+	Fr const x2 = _x.squared();
+	return x2.squared() * _x;
+}
+
+/// Adds the constants of a full round, applies the S-box to all elements and
+/// mixes with the MDS matrix.
+void fullRound(Fr* io_states, size_t _lanes, PoseidonParams const& _params, Fr const* _constants)
+{
+	size_t const t = _params.width;
+	Fr const* const mds = _params.mds.data();
+	Fr mixed[c_batchLanes * c_poseidonMaxWidth];
+	for (size_t lane = 0; lane < _lanes; ++lane)
+	{
+		Fr* s = io_states + lane * t;
+		for (size_t i = 0; i < t; ++i)
+			s[i] = pow5(s[i] + _constants[i]);
+	}
+	for (size_t i = 0; i < t; ++i)
+		for (size_t lane = 0; lane < _lanes; ++lane)
+		{
+			Fr const* s = io_states + lane * t;
+			Fr acc = mds[i * t] * s[0];
+			for (size_t j = 1; j < t; ++j)
+				acc += mds[i * t + j] * s[j];
+			mixed[lane * t + i] = acc;
+		}
+	copy(mixed, mixed + _lanes * t, io_states);
+}
+
+/// Permutes @a _lanes states of params.width elements each, stored one after
+/// the other. Every step runs over all lanes before the next one so that the
+/// independent multiplications of different states overlap.
+void permute(Fr* io_states, size_t _lanes, PoseidonParams const& _params)
+{
+	size_t const t = _params.width;
+	size_t const n = t - 1;
+	size_t const halfFull = c_poseidonFullRounds / 2;
+	Fr const* c = _params.fullConstants.data();
+	assert(_lanes <= c_batchLanes);
+
+	for (size_t round = 0; round < halfFull; ++round, c += t)
+		fullRound(io_states, _lanes, _params, c);
+
+	Fr const* sparse = _params.sparseMatrices.data();
+	for (size_t round = 0; round < _params.partialRounds; ++round, sparse += 2 * n + 1)
+		for (size_t lane = 0; lane < _lanes; ++lane)
+		{
+			Fr* s = io_states + lane * t;
+			Fr const x0 = pow5(s[0] + _params.partialConstants[round]);
+			Fr acc = sparse[0] * x0;
+			for (size_t i = 1; i < t; ++i)
+			{
+				acc += sparse[i] * s[i];
+				s[i] += sparse[n + i] * x0;
+			}
+			s[0] = acc;
+		}
+
+	Fr const* const exit = _params.partialExit.data();
+	Fr mixed[c_poseidonMaxWidth];
+	for (size_t lane = 0; lane < _lanes; ++lane)
+	{
+		Fr* s = io_states + lane * t + 1;
+		for (size_t i = 0; i < n; ++i)
+		{
+			Fr acc = exit[i * n] * s[0];
+			for (size_t j = 1; j < n; ++j)
+				acc += exit[i * n + j] * s[j];
+			mixed[i] = acc;
+		}
+		copy_n(mixed, n, s);
+	}
+
+	for (size_t round = 0; round < halfFull; ++round, c += t)
+		fullRound(io_states, _lanes, _params, c);
+}
+
+/// Hashes groups [_begin, _end) of poseidonBatch, c_batchLanes at a time.
+void hashGroups(Fr const* _inputs, size_t _arity, size_t _begin, size_t _end, Fr* o_hashes)
+{
+	PoseidonParams const& params = poseidonParams(_arity + 1);
+	size_t const t = params.width;
+	Fr states[c_batchLanes * c_poseidonMaxWidth];
+	for (size_t group = _begin; group < _end; group += c_batchLanes)
+	{
+		size_t const lanes = min(c_batchLanes, _end - group);
+		for (size_t lane = 0; lane < lanes; ++lane)
+		{
+			states[lane * t] = Fr::zero();
+			copy_n(_inputs + (group + lane) * _arity, _arity, states + lane * t + 1);
+		}
+		permute(states, lanes, params);
+		for (size_t lane = 0; lane < lanes; ++lane)
+			o_hashes[group + lane] = states[lane * t];
+	}
+}
+
+}
+
+PoseidonParams const& alt_bn128::poseidonParams(size_t _width)
+{
+	static PoseidonParams const& (* const c_params[])() = {
+		&paramsOf<2>, &paramsOf<3>, &paramsOf<4>, &paramsOf<5>,
+		&paramsOf<6>, &paramsOf<7>, &paramsOf<8>, &paramsOf<9>,
+		&paramsOf<10>, &paramsOf<11>, &paramsOf<12>, &paramsOf<13>,
+		&paramsOf<14>, &paramsOf<15>, &paramsOf<16>, &paramsOf<17>,
+	};
+	if (_width < c_poseidonMinWidth || _width > c_poseidonMaxWidth)
+		BOOST_THROW_EXCEPTION(InvalidPoseidonWidth());
+	return c_params[_width - c_poseidonMinWidth]();
+}
+
+void alt_bn128::poseidonPermute(Fr* io_state, size_t _width)
+{
+	permute(io_state, 1, poseidonParams(_width));
+}
+
+Fr alt_bn128::poseidon(Fr const* _inputs, size_t _count)
+{
+	// Validates the count before hashGroups reads the inputs.
+	poseidonParams(_count + 1);
+	Fr hash;
+	hashGroups(_inputs, _count, 0, 1, &hash);
+	return hash;
+}
+
+void alt_bn128::poseidonBatch(Fr const* _inputs, size_t _arity, size_t _count, Fr* o_hashes)
+{
+	// Below this number of hashes spawning threads costs more than it saves.
+	size_t constexpr parallelThreshold = 64;
+
+	// Generates the parameters before the workers share them.
+	poseidonParams(_arity + 1);
+	unsigned const threads = _count < parallelThreshold ? 1 : max(1u, thread::hardware_concurrency());
+	if (threads == 1)
+		hashGroups(_inputs, _arity, 0, _count, o_hashes);
+	else
+	{
+		vector<thread> workers;
+		// Whole multiples of the lanes per worker.
+		size_t const chunk = ((_count + threads - 1) / threads + c_batchLanes - 1) / c_batchLanes * c_batchLanes;
+		for (size_t begin = 0; begin < _count; begin += chunk)
+			workers.emplace_back(hashGroups, _inputs, _arity, begin, min(_count, begin + chunk), o_hashes);
+		for (auto& worker: workers)
+			worker.join();
+	}
+}
+
+Fr alt_bn128::poseidonMerkleRoot(vector<Fr> _leaves, size_t _arity)
+{
+	// Arity one would never shrink a level.
+	if (_arity < 2)
+		BOOST_THROW_EXCEPTION(InvalidPoseidonWidth());
+	poseidonParams(_arity + 1);
+	if (_leaves.empty())
+		return Fr::zero();
+	vector<Fr> nodes;
+	while (_leaves.size() > 1)
+	{
+		nodes.resize((_leaves.size() + _arity - 1) / _arity);
+		_leaves.resize(nodes.size() * _arity, Fr::zero());
+		poseidonBatch(_leaves.data(), _arity, nodes.size(), nodes.data());
+		swap(_leaves, nodes);
+	}
+	return _leaves[0];
+}
+
+PoseidonSponge::PoseidonSponge(size_t _width, Fr const& _capacity):
+	m_width(_width)
+{
+	if (_width < c_poseidonMinWidth || _width > c_poseidonMaxWidth)
+		BOOST_THROW_EXCEPTION(InvalidPoseidonWidth());
+	m_state[0] = _capacity;
+}
+
+void PoseidonSponge::absorb(Fr const& _x)
+{
+	if (m_absorbed == m_width - 1)
+	{
+		poseidonPermute(m_state, m_width);
+		m_absorbed = 0;
+	}
+	m_state[1 + m_absorbed++] += _x;
+}
+
+void PoseidonSponge::absorb(Fr const* _x, size_t _count)
+{
+	for (size_t i = 0; i < _count; ++i)
+		absorb(_x[i]);
+}
+
+Fr PoseidonSponge::squeeze()
+{
+	poseidonPermute(m_state, m_width);
+	m_absorbed = 0;
+	return m_state[0];
+}
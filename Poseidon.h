@@ -0,0 +1,103 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2014-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+/** @file Poseidon.h
+ * Poseidon hash over the scalar field of alt_bn128 with the parameters of
+ * circomlib: x^5 S-box, 8 full rounds, round constants and Cauchy MDS matrix
+ * from the Grain LFSR of the reference implementation. poseidon() of n inputs
+ * equals circomlib's Poseidon(n) for n = 1..16.
+ */
+
+#pragma once
+
+#include <libdevcrypto/Bn254.h>
+
+#include <vector>
+
+namespace dev
+{
+namespace crypto
+{
+namespace alt_bn128
+{
+
+/// Supported state widths t, i.e. 1 to 16 inputs per permutation.
+size_t constexpr c_poseidonMinWidth = 2;
+size_t constexpr c_poseidonMaxWidth = 17;
+size_t constexpr c_poseidonFullRounds = 8;
+
+/// Round constants and MDS matrix of one state width, together with the
+/// equivalent form the permutation evaluates (appendix B of the Poseidon
+/// paper): the partial rounds only add a constant to the first element and
+/// mix with a sparse matrix, which turns their t^2 multiplications into 2t.
+struct PoseidonParams
+{
+	size_t width = 0;
+	size_t partialRounds = 0;
+	/// width constants per round, full and partial rounds alike.
+	std::vector<Fr> roundConstants;
+	/// Row-major width x width matrix.
+	std::vector<Fr> mds;
+
+	/// width constants per full round, the first round after the partial
+	/// ones absorbing the constants moved out of them.
+	std::vector<Fr> fullConstants;
+	/// One constant per partial round, added to the first element.
+	std::vector<Fr> partialConstants;
+	/// Sparse matrix of every partial round as m00 | row 0 without m00 |
+	/// column 0 without m00, the rest being the identity.
+	std::vector<Fr> sparseMatrices;
+	/// Row-major (width - 1) x (width - 1) matrix applied to all elements
+	/// but the first after the last partial round.
+	std::vector<Fr> partialExit;
+};
+
+/// Parameters of width @a _width, generated on first use and kept for the
+/// lifetime of the process. Throws InvalidPoseidonWidth unless @a _width is
+/// between c_poseidonMinWidth and c_poseidonMaxWidth.
+PoseidonParams const& poseidonParams(size_t _width);
+
+/// Applies the permutation of width @a _width to @a io_state in place.
+void poseidonPermute(Fr* io_state, size_t _width);
+
+/// Hash of 1 to 16 field elements: permutes [0, inputs...] with t = count + 1
+/// and returns the first element of the state. Throws InvalidPoseidonWidth
+/// for other counts, as do poseidonBatch for other arities and
+/// poseidonMerkleRoot and PoseidonSponge for arities or widths out of range.
+Fr poseidon(Fr const* _inputs, size_t _count);
+inline Fr poseidon(std::vector<Fr> const& _inputs) { return poseidon(_inputs.data(), _inputs.size()); }
+
+/// Hashes @a _count consecutive groups of @a _arity inputs each, e.g. one
+/// level of a Merkle tree with @a _arity children per node, and writes the
+/// hashes to @a o_hashes. Interleaves independent permutations and spreads
+/// large batches over all cores.
+void poseidonBatch(Fr const* _inputs, size_t _arity, size_t _count, Fr* o_hashes);
+
+/// Root of the Merkle tree over @a _leaves with @a _arity children per node.
+/// Levels that do not fill their last node are padded with zeros.
+Fr poseidonMerkleRoot(std::vector<Fr> _leaves, size_t _arity = 2);
+
+/// Sponge over the permutation of width @a _width with rate width - 1 and the
+/// first state element as capacity. Absorbing exactly width - 1 elements and
+/// squeezing once yields poseidon() of those elements. Inputs are not padded:
+/// callers hashing inputs of variable length separate them through the
+/// initial capacity element, e.g. by the length.
+class PoseidonSponge
+{
+public:
+	explicit PoseidonSponge(size_t _width = 3, Fr const& _capacity = Fr::zero());
+
+	void absorb(Fr const& _x);
+	void absorb(Fr const* _x, size_t _count);
+	/// Permutes the state and @returns its first element.
+	Fr squeeze();
+
+private:
+	size_t m_width;
+	size_t m_absorbed = 0;
+	Fr m_state[c_poseidonMaxWidth];
+};
+
+}
+}
+}
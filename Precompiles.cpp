@@ -0,0 +1,340 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2014-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+
+#include <libdevcrypto/Precompiles.h>
+#include <libdevcrypto/Common.h>
+#include <libdevcrypto/Hash.h>
+#include <libdevcrypto/LibSnark.h>
+#include <libdevcrypto/ModExp.h>
+
+#include <libdevcore/SHA3.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+using namespace std;
+using namespace dev;
+using namespace dev::crypto;
+
+namespace
+{
+
+/// Gas of @a Base plus @a Word per 32 byte word of input.
+template <uint64_t Base, uint64_t Word>
+uint64_t linearGas(bytesConstRef _in)
+{
+	return Base + Word * ((_in.size() + 31) / 32);
+}
+
+uint64_t pairingGas(bytesConstRef _in)
+{
+	return 45000 + 34000 * (_in.size() / 192);
+}
+
+template <size_t Size>
+size_t fixedOutputSize(bytesConstRef)
+{
+	return Size;
+}
+
+size_t inputSize(bytesConstRef _in)
+{
+	return _in.size();
+}
+
+/// Pads the input to @a N bytes with zeros on the right, as the EVM reads
+/// calldata beyond its end.
+template <size_t N>
+void padInput(bytesConstRef _in, byte (&o_padded)[N])
+{
+	memset(o_padded, 0, N);
+	memcpy(o_padded, _in.data(), min(_in.size(), N));
+}
+
+// The kernels return false for invalid input and otherwise set o_size to the
+// number of bytes written to o_out, which precompileOutputSize() bounds.
+
+bool ecrecover(bytesConstRef _in, bytesRef o_out, size_t& o_size)
+{
+	// Input: hash | v | r | s, 32 bytes each, with v 27 or 28.
+	byte in[128];
+	padInput(_in, in);
+	o_size = 0;
+	if (any_of(in + 32, in + 63, [](byte _b) { return _b != 0; }) || (in[63] != 27 && in[63] != 28))
+		return true;
+
+	SignatureStruct const sig(h256(in + 64, h256::ConstructFromPointer),
+		h256(in + 96, h256::ConstructFromPointer), byte(in[63] - 27));
+	if (!sig.isValid())
+		return true;
+	try
+	{
+		if (Public const p = recover(sig, h256(in, h256::ConstructFromPointer)))
+		{
+			// The address is the low 20 bytes of the hash, left-padded.
+			h256 const hash = sha3(p.ref());
+			memset(o_out.data(), 0, 12);
+			memcpy(o_out.data() + 12, hash.data() + 12, 20);
+			o_size = 32;
+		}
+	}
+	catch (...)
+	{
+		// An unrecoverable signature yields no output.
+	}
+	return true;
+}
+
+bool sha256Kernel(bytesConstRef _in, bytesRef o_out, size_t& o_size)
+{
+	h256 const hash = sha256(_in);
+	memcpy(o_out.data(), hash.data(), 32);
+	o_size = 32;
+	return true;
+}
+
+bool ripemd160Kernel(bytesConstRef _in, bytesRef o_out, size_t& o_size)
+{
+	h160 const hash = ripemd160(_in);
+	memset(o_out.data(), 0, 12);
+	memcpy(o_out.data() + 12, hash.data(), 20);
+	o_size = 32;
+	return true;
+}
+
+bool identity(bytesConstRef _in, bytesRef o_out, size_t& o_size)
+{
+	if (!_in.empty())
+		memmove(o_out.data(), _in.data(), _in.size());
+	o_size = _in.size();
+	return true;
+}
+
+bool modexpKernel(bytesConstRef _in, bytesRef o_out, size_t& o_size)
+{
+	o_size = modexpOutputSize(_in);
+	return modexp(_in, o_out);
+}
+
+bool altBn128G1Add(bytesConstRef _in, bytesRef o_out, size_t& o_size)
+{
+	o_size = 64;
+	return alt_bn128_G1_add(_in, o_out);
+}
+
+bool altBn128G1Mul(bytesConstRef _in, bytesRef o_out, size_t& o_size)
+{
+	o_size = 64;
+	return alt_bn128_G1_mul(_in, o_out);
+}
+
+bool altBn128PairingProduct(bytesConstRef _in, bytesRef o_out, size_t& o_size)
+{
+	o_size = 32;
+	return alt_bn128_pairing_product(_in, o_out);
+}
+
+/// A row of the dispatch table.
+struct PrecompileEntry
+{
+	char const* name;
+	/// The low byte of the address, all others are zero.
+	byte address;
+	uint64_t (*gas)(bytesConstRef _in);
+	size_t (*outputSize)(bytesConstRef _in);
+	bool (*execute)(bytesConstRef _in, bytesRef o_out, size_t& o_size);
+};
+
+/// Indexed by Precompile.
+PrecompileEntry const c_precompiles[c_precompileCount] = {
+	{"ecrecover", 0x01, linearGas<3000, 0>, fixedOutputSize<32>, ecrecover},
+	{"sha256", 0x02, linearGas<60, 12>, fixedOutputSize<32>, sha256Kernel},
+	{"ripemd160", 0x03, linearGas<600, 120>, fixedOutputSize<32>, ripemd160Kernel},
+	{"identity", 0x04, linearGas<15, 3>, inputSize, identity},
+	{"modexp", 0x05, modexpGas, modexpOutputSize, modexpKernel},
+	{"alt_bn128_G1_add", 0x06, linearGas<150, 0>, fixedOutputSize<64>, altBn128G1Add},
+	{"alt_bn128_G1_mul", 0x07, linearGas<6000, 0>, fixedOutputSize<64>, altBn128G1Mul},
+	{"alt_bn128_pairing_product", 0x08, pairingGas, fixedOutputSize<32>, altBn128PairingProduct},
+};
+
+PrecompileEntry const& entryOf(Precompile _id)
+{
+	return c_precompiles[size_t(_id)];
+}
+
+struct Counters
+{
+	atomic<uint64_t> calls{0};
+	atomic<uint64_t> failures{0};
+	atomic<uint64_t> gasUsed{0};
+	atomic<uint64_t> inputBytes{0};
+	atomic<uint64_t> nanoseconds{0};
+};
+
+Counters& countersOf(Precompile _id)
+{
+	static Counters s_counters[c_precompileCount];
+	return s_counters[size_t(_id)];
+}
+
+/// Checks the output buffer and the gas of a call before it is executed.
+/// @returns false and sets @a o_result if the call must not be executed.
+bool admit(Precompile _id, bytesConstRef _in, bytesRef _out, uint64_t _gas, PrecompileResult& o_result)
+{
+	// The gas is checked first: the output size of modexp is part of the
+	// input and may be absurd in calls that cannot pay for it.
+	bool const affordable = precompileGas(_id, _in) <= _gas;
+	if (affordable && _out.size() < precompileOutputSize(_id, _in))
+	{
+		o_result = {PrecompileStatus::OutputTooSmall, 0, 0};
+		return false;
+	}
+	Counters& counters = countersOf(_id);
+	counters.calls.fetch_add(1, memory_order_relaxed);
+	counters.inputBytes.fetch_add(_in.size(), memory_order_relaxed);
+	if (!affordable)
+	{
+		counters.failures.fetch_add(1, memory_order_relaxed);
+		counters.gasUsed.fetch_add(_gas, memory_order_relaxed);
+		o_result = {PrecompileStatus::OutOfGas, _gas, 0};
+		return false;
+	}
+	return true;
+}
+
+/// @returns the result of an admitted call that took @a _nanoseconds.
+PrecompileResult settle(Precompile _id, bytesConstRef _in, uint64_t _gas, bool _ok, size_t _size, uint64_t _nanoseconds)
+{
+	Counters& counters = countersOf(_id);
+	counters.nanoseconds.fetch_add(_nanoseconds, memory_order_relaxed);
+	if (!_ok)
+	{
+		counters.failures.fetch_add(1, memory_order_relaxed);
+		counters.gasUsed.fetch_add(_gas, memory_order_relaxed);
+		return {PrecompileStatus::InvalidInput, _gas, 0};
+	}
+	uint64_t const gas = precompileGas(_id, _in);
+	counters.gasUsed.fetch_add(gas, memory_order_relaxed);
+	return {PrecompileStatus::Success, gas, _size};
+}
+
+uint64_t elapsedSince(chrono::steady_clock::time_point _start)
+{
+	return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - _start).count();
+}
+
+}
+
+char const* dev::crypto::precompileName(Precompile _id)
+{
+	return entryOf(_id).name;
+}
+
+Address dev::crypto::precompileAddress(Precompile _id)
+{
+	return Address(entryOf(_id).address);
+}
+
+bool dev::crypto::precompileAt(Address const& _address, Precompile& o_id)
+{
+	byte const last = _address[Address::size - 1];
+	if (_address != Address(last))
+		return false;
+	for (size_t i = 0; i < c_precompileCount; ++i)
+		if (c_precompiles[i].address == last)
+		{
+			o_id = Precompile(i);
+			return true;
+		}
+	return false;
+}
+
+uint64_t dev::crypto::precompileGas(Precompile _id, bytesConstRef _in)
+{
+	return entryOf(_id).gas(_in);
+}
+
+size_t dev::crypto::precompileOutputSize(Precompile _id, bytesConstRef _in)
+{
+	return entryOf(_id).outputSize(_in);
+}
+
+PrecompileResult dev::crypto::executePrecompile(Precompile _id, bytesConstRef _in, bytesRef o_out, uint64_t _gas)
+{
+	PrecompileResult result;
+	if (!admit(_id, _in, o_out, _gas, result))
+		return result;
+	auto const start = chrono::steady_clock::now();
+	size_t size = 0;
+	bool const ok = entryOf(_id).execute(_in, o_out, size);
+	return settle(_id, _in, _gas, ok, size, elapsedSince(start));
+}
+
+void dev::crypto::executePrecompiles(vector_ref<PrecompileCall> io_calls)
+{
+	size_t const pairings = count_if(io_calls.begin(), io_calls.end(),
+		[](PrecompileCall const& _call) { return _call.id == Precompile::AltBn128PairingProduct; });
+	if (pairings < 2)
+	{
+		for (auto& call: io_calls)
+			call.result = executePrecompile(call.id, call.input, call.output, call.gas);
+		return;
+	}
+
+	// The admitted pairing checks share one final exponentiation; all other
+	// calls run one by one.
+	vector<PrecompileCall*> deferred;
+	vector<bytesConstRef> inputs;
+	deferred.reserve(pairings);
+	inputs.reserve(pairings);
+	for (auto& call: io_calls)
+		if (call.id != Precompile::AltBn128PairingProduct)
+			call.result = executePrecompile(call.id, call.input, call.output, call.gas);
+		else if (admit(call.id, call.input, call.output, call.gas, call.result))
+		{
+			deferred.push_back(&call);
+			inputs.push_back(call.input);
+		}
+
+	if (deferred.empty())
+		return;
+	auto const start = chrono::steady_clock::now();
+	auto const results = alt_bn128_pairing_product_batch(inputs);
+	uint64_t const share = elapsedSince(start) / inputs.size();
+	for (size_t i = 0; i < deferred.size(); ++i)
+	{
+		PrecompileCall& call = *deferred[i];
+		if (results[i].first)
+			copy(results[i].second.begin(), results[i].second.end(), call.output.begin());
+		call.result = settle(call.id, call.input, call.gas, results[i].first, 32, share);
+	}
+}
+
+PrecompileStats dev::crypto::precompileStats(Precompile _id)
+{
+	Counters const& counters = countersOf(_id);
+	return {
+		counters.calls.load(memory_order_relaxed),
+		counters.failures.load(memory_order_relaxed),
+		counters.gasUsed.load(memory_order_relaxed),
+		counters.inputBytes.load(memory_order_relaxed),
+		counters.nanoseconds.load(memory_order_relaxed)
+	};
+}
+
+void dev::crypto::resetPrecompileStats()
+{
+	for (size_t i = 0; i < c_precompileCount; ++i)
+	{
+		Counters& counters = countersOf(Precompile(i));
+		counters.calls = 0;
+		counters.failures = 0;
+		counters.gasUsed = 0;
+		counters.inputBytes = 0;
+		counters.nanoseconds = 0;
+	}
+}
@@ -0,0 +1,108 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2014-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+/** @file Precompiles.h
+ * The precompiled contracts of this library behind one calling convention:
+ * the caller passes the input, a buffer for the output and the gas available
+ * and gets back the status, the gas used and the output size. Single calls
+ * of ecrecover, sha256, ripemd160, identity and the alt_bn128 addition and
+ * multiplication do not allocate; the pairing check only does while its
+ * result cache is enabled and modexp only for even moduli and moduli longer
+ * than 4096 bits.
+ */
+
+#pragma once
+
+#include <libdevcore/Address.h>
+#include <libdevcore/Common.h>
+
+namespace dev
+{
+namespace crypto
+{
+
+/// The precompiles in the order of their addresses, 0x01 to 0x08.
+enum class Precompile: uint8_t
+{
+	ECRecover,
+	Sha256,
+	Ripemd160,
+	Identity,
+	ModExp,
+	AltBn128G1Add,
+	AltBn128G1Mul,
+	AltBn128PairingProduct
+};
+
+size_t constexpr c_precompileCount = 8;
+
+enum class PrecompileStatus: uint8_t
+{
+	Success,
+	/// The gas needed exceeds the gas given; all of it is used.
+	OutOfGas,
+	/// The input is invalid; all gas is used.
+	InvalidInput,
+	/// The gas suffices but the output buffer is smaller than
+	/// precompileOutputSize(); nothing is executed and no gas is used.
+	OutputTooSmall
+};
+
+struct PrecompileResult
+{
+	PrecompileStatus status;
+	uint64_t gasUsed;
+	/// Bytes written to the output buffer; 0 unless the call succeeded.
+	size_t outputSize;
+};
+
+/// A call of a batch; executePrecompiles() fills in @a result.
+struct PrecompileCall
+{
+	Precompile id;
+	bytesConstRef input;
+	bytesRef output;
+	uint64_t gas;
+	PrecompileResult result;
+};
+
+/// Counters of the calls of one precompile since the last reset.
+struct PrecompileStats
+{
+	uint64_t calls;
+	/// Calls that ran out of gas or had invalid input.
+	uint64_t failures;
+	uint64_t gasUsed;
+	uint64_t inputBytes;
+	/// Wall-clock time spent executing, excluding calls that ran out of gas.
+	uint64_t nanoseconds;
+};
+
+/// The name of the precompile as used in the yellow paper and the EIPs.
+char const* precompileName(Precompile _id);
+Address precompileAddress(Precompile _id);
+/// @returns false if no precompile of this library lives at @a _address.
+bool precompileAt(Address const& _address, Precompile& o_id);
+
+/// Gas cost of a call with input @a _in, following the Berlin schedule
+/// (EIP-1108 for alt_bn128, EIP-2565 for modexp).
+uint64_t precompileGas(Precompile _id, bytesConstRef _in);
+/// The size the output buffer of a call with input @a _in must have.
+size_t precompileOutputSize(Precompile _id, bytesConstRef _in);
+
+/// Executes one call. A successful ecrecover of an invalid signature returns
+/// no output, as in the EVM.
+PrecompileResult executePrecompile(Precompile _id, bytesConstRef _in, bytesRef o_out, uint64_t _gas);
+
+/// Executes a batch of calls of any precompiles, each with the same result as
+/// executePrecompile(). Two or more pairing checks of a batch are verified
+/// together by alt_bn128_pairing_product_batch, which saves a final
+/// exponentiation per check at the price of a few small allocations and
+/// reports a failing check as passing with probability about 2^-127.
+void executePrecompiles(vector_ref<PrecompileCall> io_calls);
+
+PrecompileStats precompileStats(Precompile _id);
+void resetPrecompileStats();
+
+}
+}
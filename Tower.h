@@ -0,0 +1,391 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2014-2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+/** @file Tower.h
+ * Extension field tower Fp2 -> Fp6 -> Fp12 of pairing-friendly curves.
+ *
+ * Fp2 = Fp[u] / (u^2 + 1)
+ * Fp6 = Fp2[v] / (v^3 - xi)
+ * Fp12 = Fp6[w] / (w^2 - v)
+ *
+ * The base field and the non-residue xi are supplied by a configuration type:
+ *   using Fp = ...;
+ *   using Fp2 = Fp2T<Fp>;
+ *   static Fp2 mulByXi(Fp2 const&);
+ *   static TowerFrobenius<Config> const& frobenius();   // only for Frobenius maps
+ */
+
+#pragma once
+
+#include "Montgomery.h"
+
+#include <cstddef>
+
+namespace dev
+{
+namespace crypto
+{
+
+template <class Fp>
+class Fp2T
+{
+public:
+	Fp2T() = default;
+	Fp2T(Fp const& _c0, Fp const& _c1): c0(_c0), c1(_c1) {}
+
+	static Fp2T zero() { return Fp2T(Fp::zero(), Fp::zero()); }
+	static Fp2T one() { return Fp2T(Fp::one(), Fp::zero()); }
+
+	bool isZero() const { return c0.isZero() && c1.isZero(); }
+	bool operator==(Fp2T const& _b) const { return c0 == _b.c0 && c1 == _b.c1; }
+	bool operator!=(Fp2T const& _b) const { return !(*this == _b); }
+
+	Fp2T operator+(Fp2T const& _b) const { return Fp2T(c0 + _b.c0, c1 + _b.c1); }
+	Fp2T operator-(Fp2T const& _b) const { return Fp2T(c0 - _b.c0, c1 - _b.c1); }
+	Fp2T operator-() const { return Fp2T(-c0, -c1); }
+
+	Fp2T operator*(Fp2T const& _b) const
+	{
+		// Karatsuba
+		Fp const a = c0 * _b.c0;
+		Fp const b = c1 * _b.c1;
+		return Fp2T(a - b, (c0 + c1) * (_b.c0 + _b.c1) - a - b);
+	}
+
+	Fp2T operator*(Fp const& _b) const { return Fp2T(c0 * _b, c1 * _b); }
+
+	Fp2T& operator+=(Fp2T const& _b) { return *this = *this + _b; }
+	Fp2T& operator-=(Fp2T const& _b) { return *this = *this - _b; }
+	Fp2T& operator*=(Fp2T const& _b) { return *this = *this * _b; }
+
+	Fp2T dbl() const { return Fp2T(c0.dbl(), c1.dbl()); }
+
+	Fp2T squared() const
+	{
+		// Complex squaring
+		Fp const ab = c0 * c1;
+		return Fp2T((c0 + c1) * (c0 - c1), ab.dbl());
+	}
+
+	Fp2T inverse() const
+	{
+		Fp const t = (c0.squared() + c1.squared()).inverse();
+		return Fp2T(c0 * t, -(c1 * t));
+	}
+
+	/// The p-power Frobenius endomorphism, which for Fp2 is conjugation.
+	Fp2T conjugate() const { return Fp2T(c0, -c1); }
+	Fp2T frobeniusMap(size_t _power) const { return _power % 2 ? conjugate() : *this; }
+
+	template <class Int>
+	Fp2T pow(Int const& _e) const
+	{
+		Fp2T r = one();
+		for (size_t i = _e.numBits(); i-- > 0;)
+		{
+			r = r.squared();
+			if (_e.testBit(i))
+				r *= *this;
+		}
+		return r;
+	}
+
+	/// Square root for p = 3 mod 4 (Adj and Rodriguez-Henriquez, "Square root
+	/// computation over even extension fields", algorithm 9).
+	/// @returns false if the element is not a square.
+	bool sqrt(Fp2T& o_root) const
+	{
+		using Int = typename Fp::Int;
+		static_assert((Fp::c_modulus.data[0] & 3) == 3, "sqrt requires p = 3 mod 4.");
+		static constexpr Int c_a1Exponent = bigint::divSmall(bigint::subSmall(Fp::c_modulus, 3), 4);
+		static constexpr Int c_bExponent = bigint::divSmall(bigint::subSmall(Fp::c_modulus, 1), 2);
+
+		Fp2T const a1 = pow(c_a1Exponent);
+		Fp2T const alpha = a1.squared() * *this;
+		Fp2T const x0 = a1 * *this;
+		if (alpha == -one())
+			// u * x0
+			o_root = Fp2T(-x0.c1, x0.c0);
+		else
+			o_root = (alpha + one()).pow(c_bExponent) * x0;
+		return o_root.squared() == *this;
+	}
+
+	Fp c0;
+	Fp c1;
+};
+
+/// Frobenius coefficients of a tower; gamma[k] = xi^((p^k - 1) / 6).
+template <class Config>
+struct TowerFrobenius
+{
+	using Fp2 = typename Config::Fp2;
+
+	explicit TowerFrobenius(Fp2 const& _gamma1)
+	{
+		gamma[0] = Fp2::one();
+		for (size_t k = 1; k < 12; ++k)
+			gamma[k] = gamma[k - 1].conjugate() * _gamma1;
+		for (size_t k = 0; k < 12; ++k)
+		{
+			gamma2[k] = gamma[k].squared();
+			gamma4[k] = gamma2[k].squared();
+		}
+	}
+
+	Fp2 gamma[12];
+	Fp2 gamma2[12];
+	Fp2 gamma4[12];
+};
+
+template <class Config>
+class Fp6T
+{
+public:
+	using Fp2 = typename Config::Fp2;
+
+	Fp6T() = default;
+	Fp6T(Fp2 const& _c0, Fp2 const& _c1, Fp2 const& _c2): c0(_c0), c1(_c1), c2(_c2) {}
+
+	static Fp6T zero() { return Fp6T(Fp2::zero(), Fp2::zero(), Fp2::zero()); }
+	static Fp6T one() { return Fp6T(Fp2::one(), Fp2::zero(), Fp2::zero()); }
+
+	bool isZero() const { return c0.isZero() && c1.isZero() && c2.isZero(); }
+	bool operator==(Fp6T const& _b) const { return c0 == _b.c0 && c1 == _b.c1 && c2 == _b.c2; }
+	bool operator!=(Fp6T const& _b) const { return !(*this == _b); }
+
+	Fp6T operator+(Fp6T const& _b) const { return Fp6T(c0 + _b.c0, c1 + _b.c1, c2 + _b.c2); }
+	Fp6T operator-(Fp6T const& _b) const { return Fp6T(c0 - _b.c0, c1 - _b.c1, c2 - _b.c2); }
+	Fp6T operator-() const { return Fp6T(-c0, -c1, -c2); }
+
+	Fp6T operator*(Fp6T const& _b) const
+	{
+		Fp2 const v0 = c0 * _b.c0;
+		Fp2 const v1 = c1 * _b.c1;
+		Fp2 const v2 = c2 * _b.c2;
+		return Fp6T(
+			Config::mulByXi((c1 + c2) * (_b.c1 + _b.c2) - v1 - v2) + v0,
+			(c0 + c1) * (_b.c0 + _b.c1) - v0 - v1 + Config::mulByXi(v2),
+			(c0 + c2) * (_b.c0 + _b.c2) - v0 - v2 + v1
+		);
+	}
+
+	Fp6T operator*(Fp2 const& _b) const { return Fp6T(c0 * _b, c1 * _b, c2 * _b); }
+
+	Fp6T& operator+=(Fp6T const& _b) { return *this = *this + _b; }
+	Fp6T& operator-=(Fp6T const& _b) { return *this = *this - _b; }
+	Fp6T& operator*=(Fp6T const& _b) { return *this = *this * _b; }
+
+	Fp6T dbl() const { return Fp6T(c0.dbl(), c1.dbl(), c2.dbl()); }
+
+	Fp6T squared() const
+	{
+		// CH-SQR2 from Chung and Hasan, "Asymmetric squaring formulae"
+		Fp2 const s0 = c0.squared();
+		Fp2 const s1 = (c0 * c1).dbl();
+		Fp2 const s2 = (c0 - c1 + c2).squared();
+		Fp2 const s3 = (c1 * c2).dbl();
+		Fp2 const s4 = c2.squared();
+		return Fp6T(
+			s0 + Config::mulByXi(s3),
+			s1 + Config::mulByXi(s4),
+			s1 + s2 + s3 - s0 - s4
+		);
+	}
+
+	Fp6T inverse() const
+	{
+		Fp2 const t0 = c0.squared() - Config::mulByXi(c1 * c2);
+		Fp2 const t1 = Config::mulByXi(c2.squared()) - c0 * c1;
+		Fp2 const t2 = c1.squared() - c0 * c2;
+		Fp2 const t3 = (c0 * t0 + Config::mulByXi(c2 * t1 + c1 * t2)).inverse();
+		return Fp6T(t0 * t3, t1 * t3, t2 * t3);
+	}
+
+	/// Multiplication by v.
+	Fp6T mulByV() const { return Fp6T(Config::mulByXi(c2), c0, c1); }
+
+	/// Multiplication by _b0 + _b1 v.
+	Fp6T mulBy01(Fp2 const& _b0, Fp2 const& _b1) const
+	{
+		Fp2 const v0 = c0 * _b0;
+		Fp2 const v1 = c1 * _b1;
+		return Fp6T(
+			v0 + Config::mulByXi(c2 * _b1),
+			(c0 + c1) * (_b0 + _b1) - v0 - v1,
+			v1 + c2 * _b0
+		);
+	}
+
+	/// Multiplication by _b0 + _b2 v^2.
+	Fp6T mulBy02(Fp2 const& _b0, Fp2 const& _b2) const
+	{
+		return Fp6T(
+			c0 * _b0 + Config::mulByXi(c1 * _b2),
+			c1 * _b0 + Config::mulByXi(c2 * _b2),
+			c2 * _b0 + c0 * _b2
+		);
+	}
+
+	/// Multiplication by _b1 v.
+	Fp6T mulBy1(Fp2 const& _b1) const
+	{
+		return Fp6T(Config::mulByXi(c2 * _b1), c0 * _b1, c1 * _b1);
+	}
+
+	Fp6T frobeniusMap(size_t _power) const
+	{
+		auto const& f = Config::frobenius();
+		size_t const k = _power % 6;
+		return Fp6T(
+			c0.frobeniusMap(_power),
+			c1.frobeniusMap(_power) * f.gamma2[k],
+			c2.frobeniusMap(_power) * f.gamma4[k]
+		);
+	}
+
+	Fp2 c0;
+	Fp2 c1;
+	Fp2 c2;
+};
+
+template <class Config>
+class Fp12T
+{
+public:
+	using Fp2 = typename Config::Fp2;
+	using Fp6 = Fp6T<Config>;
+
+	Fp12T() = default;
+	Fp12T(Fp6 const& _c0, Fp6 const& _c1): c0(_c0), c1(_c1) {}
+
+	static Fp12T zero() { return Fp12T(Fp6::zero(), Fp6::zero()); }
+	static Fp12T one() { return Fp12T(Fp6::one(), Fp6::zero()); }
+
+	bool isOne() const { return c0 == Fp6::one() && c1.isZero(); }
+	bool operator==(Fp12T const& _b) const { return c0 == _b.c0 && c1 == _b.c1; }
+	bool operator!=(Fp12T const& _b) const { return !(*this == _b); }
+
+	Fp12T operator+(Fp12T const& _b) const { return Fp12T(c0 + _b.c0, c1 + _b.c1); }
+	Fp12T operator-(Fp12T const& _b) const { return Fp12T(c0 - _b.c0, c1 - _b.c1); }
+
+	Fp12T operator*(Fp12T const& _b) const
+	{
+		Fp6 const v0 = c0 * _b.c0;
+		Fp6 const v1 = c1 * _b.c1;
+		return Fp12T(v0 + v1.mulByV(), (c0 + c1) * (_b.c0 + _b.c1) - v0 - v1);
+	}
+
+	Fp12T& operator*=(Fp12T const& _b) { return *this = *this * _b; }
+
+	Fp12T squared() const
+	{
+		// Complex squaring
+		Fp6 const ab = c0 * c1;
+		return Fp12T((c0 + c1) * (c0 + c1.mulByV()) - ab - ab.mulByV(), ab.dbl());
+	}
+
+	Fp12T inverse() const
+	{
+		Fp6 const t = (c0.squared() - c1.squared().mulByV()).inverse();
+		return Fp12T(c0 * t, -(c1 * t));
+	}
+
+	/// Conjugation, i.e. the p^6-power Frobenius. For elements of the
+	/// cyclotomic subgroup this is the inverse.
+	Fp12T unitaryInverse() const { return Fp12T(c0, -c1); }
+
+	/// Multiplication by the sparse element _x0 + _x4 w^3 + _x2 w^4, the shape
+	/// of line functions on D-type twists.
+	Fp12T mulBy024(Fp2 const& _x0, Fp2 const& _x4, Fp2 const& _x2) const
+	{
+		Fp6 const a = c0.mulBy02(_x0, _x2);
+		Fp6 const b = c1.mulBy1(_x4);
+		Fp6 const e = (c0 + c1) * Fp6(_x0, _x4, _x2);
+		return Fp12T(a + b.mulByV(), e - a - b);
+	}
+
+	/// Multiplication by the sparse element _x0 + _x1 w^2 + _x4 w^3, the shape
+	/// of line functions on M-type twists.
+	Fp12T mulBy014(Fp2 const& _x0, Fp2 const& _x1, Fp2 const& _x4) const
+	{
+		Fp6 const a = c0.mulBy01(_x0, _x1);
+		Fp6 const b = c1.mulBy1(_x4);
+		Fp6 const e = (c0 + c1).mulBy01(_x0, _x1 + _x4);
+		return Fp12T(a + b.mulByV(), e - a - b);
+	}
+
+	Fp12T frobeniusMap(size_t _power) const
+	{
+		auto const& f = Config::frobenius();
+		Fp6 const b = c1.frobeniusMap(_power);
+		Fp2 const& g = f.gamma[_power % 12];
+		return Fp12T(c0.frobeniusMap(_power), Fp6(b.c0 * g, b.c1 * g, b.c2 * g));
+	}
+
+	/// Squaring of an element of the cyclotomic subgroup (Granger and Scott).
+	Fp12T cyclotomicSquared() const
+	{
+		Fp2 z0 = c0.c0;
+		Fp2 z4 = c0.c1;
+		Fp2 z3 = c0.c2;
+		Fp2 z2 = c1.c0;
+		Fp2 z1 = c1.c1;
+		Fp2 z5 = c1.c2;
+
+		// (t0 + t1 y) = (z0 + z1 y)^2, with y^2 = xi
+		Fp2 tmp = z0 * z1;
+		Fp2 const t0 = (z0 + z1) * (z0 + Config::mulByXi(z1)) - tmp - Config::mulByXi(tmp);
+		Fp2 const t1 = tmp.dbl();
+		// (t2 + t3 y) = (z2 + z3 y)^2
+		tmp = z2 * z3;
+		Fp2 const t2 = (z2 + z3) * (z2 + Config::mulByXi(z3)) - tmp - Config::mulByXi(tmp);
+		Fp2 const t3 = tmp.dbl();
+		// (t4 + t5 y) = (z4 + z5 y)^2
+		tmp = z4 * z5;
+		Fp2 const t4 = (z4 + z5) * (z4 + Config::mulByXi(z5)) - tmp - Config::mulByXi(tmp);
+		Fp2 const t5 = tmp.dbl();
+
+		z0 = (t0 - z0).dbl() + t0;
+		z1 = (t1 + z1).dbl() + t1;
+		tmp = Config::mulByXi(t5);
+		z2 = (tmp + z2).dbl() + tmp;
+		z3 = (t4 - z3).dbl() + t4;
+		z4 = (t2 - z4).dbl() + t2;
+		z5 = (t3 + z5).dbl() + t3;
+		return Fp12T(Fp6(z0, z4, z3), Fp6(z2, z1, z5));
+	}
+
+	/// Exponentiation of an element of the cyclotomic subgroup.
+	template <class Int>
+	Fp12T cyclotomicExp(Int const& _e) const
+	{
+		Fp12T r = one();
+		for (size_t i = _e.numBits(); i-- > 0;)
+		{
+			r = r.cyclotomicSquared();
+			if (_e.testBit(i))
+				r *= *this;
+		}
+		return r;
+	}
+
+	template <class Int>
+	Fp12T pow(Int const& _e) const
+	{
+		Fp12T r = one();
+		for (size_t i = _e.numBits(); i-- > 0;)
+		{
+			r = r.squared();
+			if (_e.testBit(i))
+				r *= *this;
+		}
+		return r;
+	}
+
+	Fp6 c0;
+	Fp6 c1;
+};
+
+}
+}